@@ -0,0 +1,68 @@
+#include "arrival_time_model.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace schunk_driver {
+
+namespace {
+
+// Loop gains for the phase and period corrections.  Late arrivals (positive
+// error) are mostly delay, so they move the estimate far less than early
+// ones; with symmetric gains the period estimate would be biased long.
+const double kEarlyPhaseGain = 0.5;
+const double kLatePhaseGain = 0.02;
+const double kEarlyPeriodGain = 0.005;
+const double kLatePeriodGain = 0.0002;
+
+// An error beyond this fraction of a period means the stream restarted or
+// changed period, so the model resynchronizes rather than slews.
+const double kResyncFraction = 0.5;
+
+// The period estimate may not wander further than this from nominal.
+const double kMaxPeriodDeviation = 0.1;
+
+}  // namespace
+
+ArrivalTimeModel::ArrivalTimeModel(int64_t nominal_period_ns)
+    : nominal_period_ns_(nominal_period_ns),
+      period_ns_(nominal_period_ns) {}
+
+int64_t ArrivalTimeModel::Update(int64_t arrival_ns) {
+  if (updates_since_reset_ == 0) {
+    phase_ns_ = arrival_ns;
+    last_error_ns_ = 0;
+    updates_since_reset_ = 1;
+    return arrival_ns;
+  }
+
+  const double elapsed = arrival_ns - phase_ns_;
+  const double periods = std::max(1.0, std::round(elapsed / period_ns_));
+  const double predicted = phase_ns_ + periods * period_ns_;
+  const double error = arrival_ns - predicted;
+  last_error_ns_ = error;
+
+  if (std::fabs(error) > kResyncFraction * period_ns_) {
+    period_ns_ = nominal_period_ns_;
+    phase_ns_ = arrival_ns;
+    updates_since_reset_ = 1;
+    return arrival_ns;
+  }
+
+  const bool early = error < 0;
+  phase_ns_ = predicted + (early ? kEarlyPhaseGain : kLatePhaseGain) * error;
+  period_ns_ += (early ? kEarlyPeriodGain : kLatePeriodGain) * error / periods;
+  period_ns_ = std::min(period_ns_,
+                        nominal_period_ns_ * (1 + kMaxPeriodDeviation));
+  period_ns_ = std::max(period_ns_,
+                        nominal_period_ns_ * (1 - kMaxPeriodDeviation));
+  updates_since_reset_++;
+  return static_cast<int64_t>(phase_ns_);
+}
+
+int64_t ArrivalTimeModel::next_arrival_ns() const {
+  if (updates_since_reset_ == 0) { return 0; }
+  return static_cast<int64_t>(phase_ns_ + period_ns_);
+}
+
+}  // namespace schunk_driver
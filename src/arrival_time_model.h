@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+namespace schunk_driver {
+
+/// Learns the period and phase of one periodic status stream from the
+/// arrival times of its messages, and assigns each message a de-jittered
+/// time on the host clock.
+///
+/// This is a second-order phase-locked loop: each arrival is compared with
+/// the time predicted from the previous estimate, and the error corrects
+/// both the phase and the period.  Network and scheduling delays only ever
+/// make a message late, so early arrivals are trusted more than late ones,
+/// pulling the estimate toward the lower envelope of arrival times.  Lost
+/// messages are accounted for by rounding the elapsed time to a whole number
+/// of periods.  Each update is constant time.
+class ArrivalTimeModel {
+ public:
+  /// Creates a model for a stream nominally sent every @p nominal_period_ns.
+  explicit ArrivalTimeModel(int64_t nominal_period_ns);
+
+  /// Records a message that arrived at @p arrival_ns and returns its
+  /// de-jittered arrival time.
+  int64_t Update(int64_t arrival_ns);
+
+  /// The estimated period of the stream.
+  double period_ns() const { return period_ns_; }
+
+  /// The most recent difference between actual and predicted arrival time.
+  double last_error_ns() const { return last_error_ns_; }
+
+  /// Whether enough messages have been seen for the estimate to be useful.
+  bool locked() const { return updates_since_reset_ >= kLockUpdates; }
+
+  /// The predicted arrival time of the next message, or zero if none has
+  /// been received yet.
+  int64_t next_arrival_ns() const;
+
+ private:
+  static const int kLockUpdates = 8;
+
+  const double nominal_period_ns_;
+  double period_ns_;
+  double phase_ns_ {0};  //< De-jittered time of the latest message.
+  double last_error_ns_ {0};
+  int updates_since_reset_ {0};
+};
+
+}  // namespace schunk_driver
@@ -0,0 +1,391 @@
+/// Searches the deadbands and periods of PositionForceControl and the driver
+/// loop for the best trade-off between gripper command rate, tracking error
+/// and force error.  Every combination in a grid is run against a
+/// WsgSimulator over a library of command profiles, in lockstep with a
+/// simulated clock and in parallel across all cores, as lockstep_sim does.
+///
+/// Prints one CSV row per combination, marking those on the Pareto front,
+/// and writes the front's best combination within --max_commands_per_s as a
+/// config for schunk_driver --config.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#include "clock.h"
+#include "driver_config.h"
+#include "in_process_transport.h"
+#include "position_force_control.h"
+#include "wsg.h"
+#include "wsg_simulator.h"
+
+DEFINE_string(force_deadbands, "1,2,5,10",
+              "Comma-separated force deadbands (N) to try");
+DEFINE_string(position_deadbands_mm, "2,5",
+              "Comma-separated position deadbands (mm) to try; these matter "
+              "only with --native_grasp");
+DEFINE_string(status_periods_ms, "10,20,50",
+              "Comma-separated status stream periods (ms) to try");
+DEFINE_string(loop_periods_ms, "10,20,50",
+              "Comma-separated driver loop periods (ms) to try");
+DEFINE_string(predict_motion, "0,1",
+              "Comma-separated settings (0 or 1) of motion prediction to try");
+DEFINE_string(profiles, "",
+              "Comma-separated CSV files of recorded command profiles to run "
+              "in addition to the synthetic ones; each line holds time (s), "
+              "target width (mm), force (N) and optionally part width (mm)");
+DEFINE_bool(native_grasp, false,
+            "Tune native Grasp/Release control instead of PrePosition "
+            "emulation");
+DEFINE_int32(threads, 0,
+             "Number of worker threads; 0 uses one per hardware thread");
+DEFINE_double(max_commands_per_s, 20,
+              "Highest gripper command rate acceptable in the chosen config");
+DEFINE_string(output_config, "",
+              "File to write the chosen config to; empty (the default) to "
+              "only report");
+
+namespace schunk_driver {
+namespace {
+
+// Resolution of the simulation.
+const int64_t kStepNs = 1000000;
+// An arbitrary but realistic epoch for simulated time.
+const int64_t kStartNs = 1500000000L * 1000000000L;
+// Measured force (N) above which the fingers are taken to be on the part,
+// where position error is no longer meaningful.
+const double kContactForce = 1;
+
+/// A command sequence, held from each point until the next.
+struct Profile {
+  struct Point {
+    double t_s {0};
+    double target_mm {0};
+    double force {0};
+  };
+  std::string name;
+  double part_width_mm {0};  //< Zero for no part.
+  double duration_s {0};
+  std::vector<Point> points;
+};
+
+Profile SampleProfile(
+    const std::string& name, double part_width_mm, double duration_s,
+    std::function<void(double, Profile::Point*)> function) {
+  Profile profile;
+  profile.name = name;
+  profile.part_width_mm = part_width_mm;
+  profile.duration_s = duration_s;
+  const double kSamplePeriodS = 0.01;
+  for (double t = 0; t < duration_s; t += kSamplePeriodS) {
+    Profile::Point point;
+    point.t_s = t;
+    function(t, &point);
+    profile.points.push_back(point);
+  }
+  return profile;
+}
+
+std::vector<Profile> SyntheticProfiles() {
+  std::vector<Profile> profiles;
+  profiles.push_back(SampleProfile(
+      "steps", 0, 8, [](double t, Profile::Point* point) {
+        point->target_mm = (static_cast<int>(t) % 2) ? 20 : 90;
+        point->force = 20;
+      }));
+  profiles.push_back(SampleProfile(
+      "sine", 0, 8, [](double t, Profile::Point* point) {
+        point->target_mm = 55 + 30 * sin(2 * M_PI * 0.5 * t);
+        point->force = 20;
+      }));
+  profiles.push_back(SampleProfile(
+      "grasp", 40, 8, [](double t, Profile::Point* point) {
+        point->target_mm = (t < 1 || t >= 6) ? 110 : 0;
+        point->force = (t < 4) ? 40 : 20;
+      }));
+  profiles.push_back(SampleProfile(
+      "force_ramp", 60, 8, [](double t, Profile::Point* point) {
+        point->target_mm = (t < 1) ? 110 : 0;
+        point->force = 10 + 50 * std::min(1.0, t / 6);
+      }));
+  return profiles;
+}
+
+bool ReadProfile(const std::string& path, Profile* profile) {
+  std::ifstream in(path);
+  if (!in) {
+    std::cerr << "Could not read profile " << path << std::endl;
+    return false;
+  }
+  profile->name = path;
+  std::string line;
+  while (std::getline(in, line)) {
+    std::replace(line.begin(), line.end(), ',', ' ');
+    std::istringstream fields(line);
+    Profile::Point point;
+    if (!(fields >> point.t_s >> point.target_mm >> point.force)) {
+      continue;  // Headers and blank lines.
+    }
+    double part_width_mm;
+    if (fields >> part_width_mm) { profile->part_width_mm = part_width_mm; }
+    profile->points.push_back(point);
+  }
+  if (profile->points.empty()) {
+    std::cerr << "No points in profile " << path << std::endl;
+    return false;
+  }
+  profile->duration_s = profile->points.back().t_s;
+  return true;
+}
+
+template <typename T>
+std::vector<T> ParseList(const std::string& list) {
+  std::vector<T> result;
+  std::istringstream items(list);
+  std::string item;
+  while (std::getline(items, item, ',')) {
+    std::istringstream value(item);
+    T parsed;
+    if (value >> parsed) { result.push_back(parsed); }
+  }
+  return result;
+}
+
+struct Metrics {
+  double commands_per_s {0};
+  double tracking_error_mm {0};  //< RMS, out of contact.
+  /// RMS difference (N) between measured and target force, in contact.
+  /// The simulated gripper never exceeds its force limit, so this, rather
+  /// than overshoot past the limit, is what the force deadband trades.
+  double force_error {0};
+};
+
+Metrics RunProfile(const DriverConfig& config, const Profile& profile) {
+  WsgSimulatorParams params;
+  WsgSimulator simulator(params);
+  SimulatedClock clock(kStartNs, kStepNs);
+
+  // The command in effect, and error accumulated at every simulation step.
+  Profile::Point command;
+  bool measuring = false;
+  double squared_error_sum = 0;
+  int64_t error_samples = 0;
+  double squared_force_error_sum = 0;
+  int64_t force_error_samples = 0;
+  clock.set_stepper([&](int64_t now_ns) {
+      simulator.Step(now_ns);
+      if (!measuring) { return; }
+      if (simulator.force() > kContactForce) {
+        const double force_error = simulator.force() - command.force;
+        squared_force_error_sum += force_error * force_error;
+        force_error_samples++;
+      } else {
+        // Aim no further in than the part allows.
+        const double reachable_mm =
+            std::max(command.target_mm, profile.part_width_mm);
+        const double error_mm = std::min<double>(
+            reachable_mm, params.stroke_mm) - simulator.width_mm();
+        squared_error_sum += error_mm * error_mm;
+        error_samples++;
+      }
+    });
+
+  PositionForceControl control(
+      std::unique_ptr<Wsg>(new Wsg(
+          std::unique_ptr<WsgTransport>(
+              new InProcessTransport(&simulator, &clock)),
+          &clock)),
+      config.control);
+  control.DoCalibrationSteps();
+  const uint64_t calibration_commands = simulator.commands_received();
+  simulator.set_part_width_mm(profile.part_width_mm);
+
+  const PositionForceControl::ControlMode mode =
+      FLAGS_native_grasp ? PositionForceControl::kNativeGrasp
+                         : PositionForceControl::kPrepositionEmulation;
+  const int64_t start_ns = clock.NowNs();
+  const int64_t end_ns = start_ns + profile.duration_s * 1e9;
+  size_t next_point = 0;
+  measuring = true;
+  while (clock.NowNs() < end_ns) {
+    const double t_s = (clock.NowNs() - start_ns) / 1e9;
+    while (next_point < profile.points.size() &&
+           profile.points[next_point].t_s <= t_s) {
+      command = profile.points[next_point++];
+    }
+    control.Task();
+    control.SetPositionAndForce(command.target_mm, command.force, mode, 0);
+    clock.SleepForNs(config.loop_period_ms * 1000000L);
+  }
+
+  Metrics metrics;
+  metrics.commands_per_s =
+      (simulator.commands_received() - calibration_commands) /
+      profile.duration_s;
+  metrics.tracking_error_mm =
+      error_samples ? std::sqrt(squared_error_sum / error_samples) : 0;
+  metrics.force_error = force_error_samples
+      ? std::sqrt(squared_force_error_sum / force_error_samples) : 0;
+  return metrics;
+}
+
+struct Candidate {
+  DriverConfig config;
+  Metrics metrics;
+  bool pareto {false};
+};
+
+// Whether @p a is no worse than @p b in every metric and better in one.
+bool Dominates(const Metrics& a, const Metrics& b) {
+  const bool no_worse = a.commands_per_s <= b.commands_per_s &&
+      a.tracking_error_mm <= b.tracking_error_mm &&
+      a.force_error <= b.force_error;
+  const bool better = a.commands_per_s < b.commands_per_s ||
+      a.tracking_error_mm < b.tracking_error_mm ||
+      a.force_error < b.force_error;
+  return no_worse && better;
+}
+
+int DoMain() {
+  std::vector<Profile> profiles = SyntheticProfiles();
+  for (const std::string& path : ParseList<std::string>(FLAGS_profiles)) {
+    Profile profile;
+    if (!ReadProfile(path, &profile)) { return 1; }
+    profiles.push_back(profile);
+  }
+
+  std::vector<Candidate> candidates;
+  for (double force_deadband : ParseList<double>(FLAGS_force_deadbands)) {
+    for (double position_deadband_mm :
+             ParseList<double>(FLAGS_position_deadbands_mm)) {
+      for (int status_period_ms : ParseList<int>(FLAGS_status_periods_ms)) {
+        for (int loop_period_ms : ParseList<int>(FLAGS_loop_periods_ms)) {
+          for (int predict_motion : ParseList<int>(FLAGS_predict_motion)) {
+            Candidate candidate;
+            candidate.config.control.force_deadband = force_deadband;
+            candidate.config.control.position_deadband_mm =
+                position_deadband_mm;
+            candidate.config.control.status_period_ms = status_period_ms;
+            candidate.config.control.predict_motion = predict_motion != 0;
+            candidate.config.loop_period_ms = loop_period_ms;
+            candidates.push_back(candidate);
+          }
+        }
+      }
+    }
+  }
+  if (candidates.empty()) {
+    std::cerr << "Empty parameter grid" << std::endl;
+    return 1;
+  }
+
+  // Each work item is one candidate over one profile.
+  const int num_items = candidates.size() * profiles.size();
+  std::vector<Metrics> results(num_items);
+  const int num_threads = (FLAGS_threads > 0)
+      ? FLAGS_threads
+      : std::max(1u, std::thread::hardware_concurrency());
+  std::atomic<int> next_item(0);
+  const auto wall_start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int i = 0; i < num_threads; i++) {
+    workers.emplace_back([&]() {
+        int item;
+        while ((item = next_item++) < num_items) {
+          results[item] = RunProfile(candidates[item / profiles.size()].config,
+                                     profiles[item % profiles.size()]);
+        }
+      });
+  }
+  for (auto& worker : workers) { worker.join(); }
+  const double wall_s = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - wall_start).count();
+
+  // Average each metric over profiles.
+  for (size_t c = 0; c < candidates.size(); c++) {
+    Metrics& metrics = candidates[c].metrics;
+    for (size_t p = 0; p < profiles.size(); p++) {
+      const Metrics& result = results[c * profiles.size() + p];
+      metrics.commands_per_s += result.commands_per_s / profiles.size();
+      metrics.tracking_error_mm += result.tracking_error_mm / profiles.size();
+      metrics.force_error += result.force_error / profiles.size();
+    }
+  }
+  for (Candidate& candidate : candidates) {
+    candidate.pareto = std::none_of(
+        candidates.begin(), candidates.end(), [&](const Candidate& other) {
+          return Dominates(other.metrics, candidate.metrics);
+        });
+  }
+
+  printf("force_deadband,position_deadband_mm,status_period_ms,"
+         "predict_motion,loop_period_ms,commands_per_s,tracking_error_mm,"
+         "force_error,pareto\n");
+  const Candidate* chosen = nullptr;
+  for (const Candidate& candidate : candidates) {
+    const DriverConfig& config = candidate.config;
+    const Metrics& metrics = candidate.metrics;
+    printf("%g,%g,%d,%d,%d,%.3f,%.3f,%.3f,%d\n",
+           config.control.force_deadband, config.control.position_deadband_mm,
+           config.control.status_period_ms,
+           config.control.predict_motion ? 1 : 0, config.loop_period_ms,
+           metrics.commands_per_s, metrics.tracking_error_mm,
+           metrics.force_error, candidate.pareto ? 1 : 0);
+    if (!candidate.pareto) { continue; }
+    // Prefer the most accurate point within the rate limit; failing any,
+    // the lowest rate.
+    const bool within = metrics.commands_per_s <= FLAGS_max_commands_per_s;
+    if (!chosen) {
+      chosen = &candidate;
+      continue;
+    }
+    const Metrics& best = chosen->metrics;
+    const bool best_within = best.commands_per_s <= FLAGS_max_commands_per_s;
+    if (within != best_within) {
+      if (within) { chosen = &candidate; }
+    } else if (within) {
+      if (std::make_pair(metrics.tracking_error_mm, metrics.force_error) <
+          std::make_pair(best.tracking_error_mm, best.force_error)) {
+        chosen = &candidate;
+      }
+    } else if (metrics.commands_per_s < best.commands_per_s) {
+      chosen = &candidate;
+    }
+  }
+
+  fprintf(stderr, "Simulated %zu configs x %zu profiles on %d threads "
+          "in %.3fs\n", candidates.size(), profiles.size(), num_threads,
+          wall_s);
+  std::cerr << "Chosen config:\n";
+  WriteDriverConfig(chosen->config, std::cerr);
+  if (!FLAGS_output_config.empty()) {
+    std::ofstream out(FLAGS_output_config);
+    out << "# Written by autotune; load with schunk_driver --config.\n";
+    WriteDriverConfig(chosen->config, out);
+    if (!out) {
+      std::cerr << "Could not write " << FLAGS_output_config << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace schunk_driver
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  return schunk_driver::DoMain();
+}
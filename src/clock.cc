@@ -0,0 +1,76 @@
+#include "clock.h"
+
+#include <cassert>
+#include <ctime>
+
+namespace schunk_driver {
+
+SystemClock* SystemClock::Get() {
+  static SystemClock instance;
+  return &instance;
+}
+
+int64_t SystemClock::NowNs() const {
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+int64_t SystemClock::MonotonicNs() const {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+void SystemClock::SleepForNs(int64_t duration_ns) {
+  if (duration_ns <= 0) { return; }
+  struct timespec duration;
+  duration.tv_sec = duration_ns / 1000000000L;
+  duration.tv_nsec = duration_ns % 1000000000L;
+  while (nanosleep(&duration, &duration) != 0) {}
+}
+
+int64_t SystemClock::WaitUntilMonotonicNs(int64_t deadline_ns,
+                                          int64_t spin_ns) {
+  const int64_t wake_ns = deadline_ns - spin_ns;
+  if (MonotonicNs() < wake_ns) {
+    struct timespec wake;
+    wake.tv_sec = wake_ns / 1000000000L;
+    wake.tv_nsec = wake_ns % 1000000000L;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake,
+                           nullptr) != 0) {}
+  }
+  int64_t now_ns;
+  while ((now_ns = MonotonicNs()) < deadline_ns) {}
+  return now_ns;
+}
+
+SimulatedClock::SimulatedClock(int64_t start_ns, int64_t step_ns)
+    : step_ns_(step_ns),
+      now_ns_(start_ns) {
+  assert(step_ns_ > 0);
+}
+
+void SimulatedClock::SleepForNs(int64_t duration_ns) {
+  const int64_t end_ns = now_ns_ + duration_ns;
+  while (now_ns_ < end_ns) {
+    Step();
+  }
+}
+
+int64_t SimulatedClock::WaitUntilMonotonicNs(int64_t deadline_ns,
+                                             int64_t spin_ns) {
+  while (now_ns_ < deadline_ns) {
+    Step();
+  }
+  return now_ns_;
+}
+
+void SimulatedClock::Step() {
+  now_ns_ += step_ns_;
+  if (stepper_) {
+    stepper_(now_ns_);
+  }
+}
+
+}  // namespace schunk_driver
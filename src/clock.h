@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace schunk_driver {
+
+/// The source of time and the means of waiting for everything in the driver
+/// that depends on either.  Substituting a SimulatedClock lets the driver run
+/// in lockstep with a simulated gripper, faster than real time.
+class Clock {
+ public:
+  virtual ~Clock() {}
+
+  /// Wall-clock time, in nanoseconds since the epoch.
+  virtual int64_t NowNs() const = 0;
+
+  /// Time in nanoseconds from an arbitrary origin that, unlike NowNs(),
+  /// never steps backwards.
+  virtual int64_t MonotonicNs() const = 0;
+
+  /// Waits for @p duration_ns to elapse.
+  virtual void SleepForNs(int64_t duration_ns) = 0;
+
+  /// Returns as close as possible to MonotonicNs() @p deadline_ns: a real
+  /// clock sleeps until @p spin_ns before it, which leaves the scheduler's
+  /// wakeup latency behind, then spins.  Returns MonotonicNs() on return,
+  /// which is later than @p deadline_ns if that had already passed.
+  virtual int64_t WaitUntilMonotonicNs(int64_t deadline_ns,
+                                       int64_t spin_ns) = 0;
+
+  /// Called by polling loops each time they find nothing to do.  A real
+  /// clock returns immediately; a simulated one lets time pass.
+  virtual void Idle() = 0;
+
+  int64_t NowUtime() const { return NowNs() / 1000; }
+};
+
+/// The host's real-time clock.  Idle() does nothing, so polling loops spin.
+class SystemClock : public Clock {
+ public:
+  /// The process-wide instance.
+  static SystemClock* Get();
+
+  int64_t NowNs() const override;
+  int64_t MonotonicNs() const override;
+  void SleepForNs(int64_t duration_ns) override;
+  int64_t WaitUntilMonotonicNs(int64_t deadline_ns,
+                               int64_t spin_ns) override;
+  void Idle() override {}
+};
+
+/// A clock that advances only when waited upon, in fixed steps, notifying a
+/// stepper (typically a simulated gripper) after each step.  Not thread-safe;
+/// each simulated scenario should have its own.
+class SimulatedClock : public Clock {
+ public:
+  typedef std::function<void(int64_t now_ns)> Stepper;
+
+  /// Starts at @p start_ns and advances @p step_ns at a time.
+  SimulatedClock(int64_t start_ns, int64_t step_ns);
+
+  void set_stepper(Stepper stepper) { stepper_ = std::move(stepper); }
+
+  int64_t NowNs() const override { return now_ns_; }
+  int64_t MonotonicNs() const override { return now_ns_; }
+
+  /// Advances time by @p duration_ns, rounded up to a whole number of steps.
+  void SleepForNs(int64_t duration_ns) override;
+
+  /// Advances time to @p deadline_ns, rounded up to a whole number of steps;
+  /// there is no wakeup latency to spin through.
+  int64_t WaitUntilMonotonicNs(int64_t deadline_ns,
+                               int64_t spin_ns) override;
+
+  /// Advances time by a single step.
+  void Idle() override { Step(); }
+
+ private:
+  void Step();
+
+  const int64_t step_ns_;
+  int64_t now_ns_;
+  Stepper stepper_;
+};
+
+}  // namespace schunk_driver
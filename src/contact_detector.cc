@@ -0,0 +1,89 @@
+#include "contact_detector.h"
+
+#include <cmath>
+
+#include "wsg_command_message.h"
+
+namespace schunk_driver {
+
+ContactDetector::ContactDetector(const ContactDetectorParams& params)
+    : params_(params) {}
+
+bool ContactDetector::Update(const StatusSample& sample,
+                             const StatusHistory& history,
+                             ContactEvent* event) {
+  switch (sample.command) {
+    case kGetGraspState: {
+      const GraspingState previous = last_grasping_state_;
+      last_grasping_state_ = sample.grasping_state;
+      if (sample.grasping_state == previous) { return false; }
+      if (sample.grasping_state == kPartLost) {
+        in_contact_ = false;
+        return Emit(ContactEvent::kPartLost, sample, event);
+      }
+      if (sample.grasping_state == kHolding && !in_contact_) {
+        in_contact_ = true;
+        contact_position_mm_ = sample.position_mm;
+        return Emit(ContactEvent::kContact, sample, event);
+      }
+      return false;
+    }
+    case kGetForce:
+    case kGetOpeningWidth: {
+      if (!in_contact_) {
+        if (sample.force >= params_.contact_force) {
+          in_contact_ = true;
+          contact_position_mm_ = sample.position_mm;
+          return Emit(ContactEvent::kContact, sample, event);
+        }
+        return false;
+      }
+      if (sample.force < params_.release_force) {
+        in_contact_ = false;
+        // Losing force while opening is an ordinary release; losing it while
+        // the fingers close past the contact point means the part is gone.
+        if (contact_position_mm_ - sample.position_mm >
+            params_.slip_width_change_mm) {
+          return Emit(ContactEvent::kPartLost, sample, event);
+        }
+        return false;
+      }
+      if (sample.monotonic_utime - last_slip_utime_ <
+          params_.slip_window_us) {
+        return false;  // Report each slip once per window.
+      }
+      const StatusHistory::Window window =
+          history.Latest(params_.slip_window_us);
+      const StatusHistory::Stats force =
+          history.Summarize(StatusHistory::kForce, window);
+      const StatusHistory::Stats width =
+          history.Summarize(StatusHistory::kPositionMm, window);
+      const double force_drop = force.max - sample.force;
+      const double width_change = width.max - width.min;
+      if (force_drop >= params_.slip_force_drop &&
+          width_change >= params_.slip_width_change_mm) {
+        last_slip_utime_ = sample.monotonic_utime;
+        Emit(ContactEvent::kSlip, sample, event);
+        event->force_drop = force_drop;
+        event->width_change_mm = width_change;
+        return true;
+      }
+      return false;
+    }
+    default: return false;
+  }
+}
+
+bool ContactDetector::Emit(ContactEvent::Type type,
+                           const StatusSample& sample,
+                           ContactEvent* event) {
+  *event = ContactEvent();
+  event->type = type;
+  event->sample_utime = sample.receive_utime;
+  event->position_mm = sample.position_mm;
+  event->force = sample.force;
+  event->grasping_state = sample.grasping_state;
+  return true;
+}
+
+}  // namespace schunk_driver
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+
+#include "position_force_control.h"
+#include "status_history.h"
+
+namespace schunk_driver {
+
+/// Thresholds for ContactDetector.  Forces are in Newtons, widths in
+/// millimeters of base separation.
+struct ContactDetectorParams {
+  /// Force at or above which the fingers are considered in contact.
+  double contact_force {5};
+  /// Force below which contact is considered broken (hysteresis).
+  double release_force {2};
+  /// Span of history examined for slip.
+  int64_t slip_window_us {100000};
+  /// Slip requires force to fall at least this far below its window peak...
+  double slip_force_drop {3};
+  /// ...while the fingers move at least this far.
+  double slip_width_change_mm {1};
+};
+
+/// A contact-related event detected from gripper status.
+struct ContactEvent {
+  enum Type { kContact = 0, kPartLost = 1, kSlip = 2 };
+  Type type {kContact};
+  int64_t sample_utime {0};  //< Receive time of the triggering sample.
+  double position_mm {0};
+  double force {0};
+  double force_drop {0};  //< Force lost over the slip window.
+  double width_change_mm {0};  //< Finger travel over the slip window.
+  GraspingState grasping_state {kIdle};
+};
+
+/// Detects contact onset, loss of a grasped part, and slip from the stream
+/// of status samples, one sample at a time, so that reaction time is bounded
+/// by the arrival of a single status message.
+///
+/// Part loss is reported either when the firmware enters its kPartLost
+/// grasping state or when force vanishes while the fingers close past the
+/// point of contact.  Slip is a drop in force accompanied by finger motion
+/// while in contact.
+class ContactDetector {
+ public:
+  explicit ContactDetector(const ContactDetectorParams& params);
+
+  /// Examines @p sample, which must already be the newest sample recorded
+  /// in @p history.  Returns true and fills @p event if an event occurred.
+  bool Update(const StatusSample& sample, const StatusHistory& history,
+              ContactEvent* event);
+
+  bool in_contact() const { return in_contact_; }
+
+ private:
+  bool Emit(ContactEvent::Type type, const StatusSample& sample,
+            ContactEvent* event);
+
+  const ContactDetectorParams params_;
+  bool in_contact_ {false};
+  double contact_position_mm_ {0};
+  GraspingState last_grasping_state_ {kIdle};
+  int64_t last_slip_utime_ {0};
+};
+
+}  // namespace schunk_driver
@@ -1,10 +1,12 @@
+#pragma once
+
 #include <cstdint>
 
 namespace schunk_driver {
 
 // This code for calculating the checksum was copied from the WSG
 // Command Set Reference Manual.
-const uint16_t CRC_TABLE[256] = {
+static const uint16_t CRC_TABLE[256] = {
   0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
   0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
   0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
@@ -39,7 +41,7 @@ const uint16_t CRC_TABLE[256] = {
   0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0
 };
 
-uint16_t checksum_update_crc16(unsigned char *data, int size) {
+inline uint16_t checksum_update_crc16(const unsigned char *data, int size) {
 
   int c;
   uint16_t crc = 0xFFFF;
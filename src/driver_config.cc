@@ -0,0 +1,61 @@
+#include "driver_config.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace schunk_driver {
+
+bool ReadDriverConfig(const std::string& path, DriverConfig* config) {
+  std::ifstream in(path);
+  if (!in) {
+    std::cerr << "Could not read config " << path << std::endl;
+    return false;
+  }
+  std::string line;
+  int line_number = 0;
+  while (std::getline(in, line)) {
+    line_number++;
+    std::istringstream words(line);
+    std::string name;
+    if (!(words >> name) || name[0] == '#') { continue; }
+    ControlParams& control = config->control;
+    bool ok = false;
+    if (name == "force_deadband") {
+      ok = (words >> control.force_deadband) && control.force_deadband >= 0;
+    } else if (name == "position_deadband_mm") {
+      ok = (words >> control.position_deadband_mm) &&
+          control.position_deadband_mm >= 0;
+    } else if (name == "status_period_ms") {
+      // The gripper takes the period as 16 bits.
+      ok = (words >> control.status_period_ms) &&
+          control.status_period_ms > 0 && control.status_period_ms <= 0xffff;
+    } else if (name == "predict_motion") {
+      ok = static_cast<bool>(words >> control.predict_motion);
+    } else if (name == "loop_period_ms") {
+      // Without a pause between iterations, commands flood the gripper.
+      ok = (words >> config->loop_period_ms) && config->loop_period_ms > 0;
+    } else {
+      std::cerr << path << ":" << line_number << ": unknown name "
+                << name << std::endl;
+      return false;
+    }
+    if (!ok) {
+      std::cerr << path << ":" << line_number << ": bad value for "
+                << name << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+void WriteDriverConfig(const DriverConfig& config, std::ostream& out) {
+  out << "force_deadband " << config.control.force_deadband << "\n"
+      << "position_deadband_mm " << config.control.position_deadband_mm
+      << "\n"
+      << "status_period_ms " << config.control.status_period_ms << "\n"
+      << "predict_motion " << config.control.predict_motion << "\n"
+      << "loop_period_ms " << config.loop_period_ms << "\n";
+}
+
+}  // namespace schunk_driver
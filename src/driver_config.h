@@ -0,0 +1,29 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+
+#include "position_force_control.h"
+
+namespace schunk_driver {
+
+/// Tunable timing and deadbands of the driver, as found by autotune.
+struct DriverConfig {
+  ControlParams control;
+  /// Period (ms) of the driver's main loop, which relays one command per
+  /// iteration.
+  int loop_period_ms {50};
+};
+
+/// Reads @p config from the file at @p path, which holds one "name value"
+/// pair per line (blank lines and lines beginning with '#' are ignored).
+/// Names not present keep their current values.  Returns false, with a
+/// message on std::cerr, if the file cannot be read or holds an unknown
+/// name or a malformed or out of range value: a negative deadband, or a
+/// period that is not positive (or for status_period_ms, exceeds 65535).
+bool ReadDriverConfig(const std::string& path, DriverConfig* config);
+
+/// Writes @p config in the format read by ReadDriverConfig().
+void WriteDriverConfig(const DriverConfig& config, std::ostream& out);
+
+}  // namespace schunk_driver
@@ -0,0 +1,106 @@
+#include "fake_wsg_server.h"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "clock.h"
+
+namespace schunk_driver {
+
+FakeWsgServer::FakeWsgServer(const WsgSimulatorParams& params,
+                             in_port_t gripper_port, in_port_t driver_port)
+    : fd_(socket(AF_INET, SOCK_DGRAM, 0)),
+      simulator_(params) {
+  assert(fd_ > 0);
+  struct sockaddr_in local_sockaddr;
+  memset(&local_sockaddr, 0, sizeof(local_sockaddr));
+  local_sockaddr.sin_family = AF_INET;
+  local_sockaddr.sin_port = htons(gripper_port);
+  local_sockaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int bind_result = bind(fd_, (struct sockaddr *) &local_sockaddr,
+                         sizeof(local_sockaddr));
+  if (bind_result != 0) {
+    std::cerr << "bind failed: " << errno << std::endl;
+    assert(bind_result == 0);
+  }
+  memset(&driver_sockaddr_, 0, sizeof(driver_sockaddr_));
+  driver_sockaddr_.sin_family = AF_INET;
+  driver_sockaddr_.sin_port = htons(driver_port);
+  driver_sockaddr_.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+FakeWsgServer::~FakeWsgServer() {
+  Stop();
+  close(fd_);
+}
+
+void FakeWsgServer::Start() {
+  assert(!running_);
+  running_ = true;
+  thread_ = std::thread(&FakeWsgServer::Run, this);
+}
+
+void FakeWsgServer::Stop() {
+  if (!running_) { return; }
+  running_ = false;
+  thread_.join();
+}
+
+std::vector<FakeWsgServer::CommandRecord> FakeWsgServer::TakeCommandLog() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<CommandRecord> result;
+  result.swap(command_log_);
+  return result;
+}
+
+void FakeWsgServer::SetPartWidth(double width_mm) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  simulator_.set_part_width_mm(width_mm);
+}
+
+void FakeWsgServer::Run() {
+  Clock* clock = SystemClock::Get();
+  unsigned char buffer[1024];
+  std::vector<unsigned char> frame;
+  while (running_) {
+    // Wake at least every millisecond to advance the simulation.
+    struct pollfd pfd = { fd_, POLLIN, 0 };
+    const int ready = poll(&pfd, 1, 1);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ready > 0) {
+      ssize_t size;
+      while ((size = recv(fd_, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+        const int64_t now_ns = clock->NowNs();
+        std::unique_ptr<WsgCommandMessage> command =
+            WsgCommandMessage::Parse(buffer, size);
+        if (!command) {
+          std::cerr << "fake gripper: malformed command" << std::endl;
+          continue;
+        }
+        CommandRecord record;
+        record.command = command->command();
+        record.receive_ns = now_ns;
+        command_log_.push_back(record);
+        simulator_.HandleCommand(*command, now_ns);
+      }
+    }
+
+    const int64_t now_ns = clock->NowNs();
+    simulator_.Step(now_ns);
+    std::unique_ptr<WsgReturnMessage> response;
+    while ((response = simulator_.TakeResponse(now_ns))) {
+      response->Serialize(frame);
+      sendto(fd_, frame.data(), frame.size(), 0,
+             (struct sockaddr *) &driver_sockaddr_, sizeof(driver_sockaddr_));
+    }
+  }
+}
+
+}  // namespace schunk_driver
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+
+#include "wsg_simulator.h"
+
+namespace schunk_driver {
+
+/// Serves a WsgSimulator over UDP, in real time, as a stand-in for a gripper
+/// on the local host.  The simulator runs on a background thread that also
+/// logs the arrival time of every command, so that a test harness can
+/// measure what the driver puts on the wire.
+class FakeWsgServer {
+ public:
+  /// A command received from the driver.
+  struct CommandRecord {
+    int command {0};
+    int64_t receive_ns {0};  //< Host wall-clock time of arrival.
+  };
+
+  /// Listens on 127.0.0.1:@p gripper_port and replies to
+  /// 127.0.0.1:@p driver_port, as a gripper configured with those ports
+  /// would.
+  FakeWsgServer(const WsgSimulatorParams& params,
+                in_port_t gripper_port, in_port_t driver_port);
+
+  /// Stops the server if it is running.
+  ~FakeWsgServer();
+
+  void Start();
+  void Stop();
+
+  /// Removes and returns the commands received since the last call.
+  std::vector<CommandRecord> TakeCommandLog();
+
+  /// Places or removes (if zero) a part between the simulated fingers.
+  void SetPartWidth(double width_mm);
+
+ private:
+  void Run();
+
+  const int fd_;
+  struct sockaddr_in driver_sockaddr_;
+  WsgSimulator simulator_;
+  std::atomic<bool> running_ {false};
+  std::thread thread_;
+
+  std::mutex mutex_;  //< Guards the members below and simulator_.
+  std::vector<CommandRecord> command_log_;
+};
+
+}  // namespace schunk_driver
@@ -0,0 +1,155 @@
+#include "finger_data.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "wsg_command_message.h"
+
+namespace schunk_driver {
+
+namespace {
+
+// A request that has gone unanswered this many poll periods is abandoned.
+const int kRequestTimeoutPeriods = 10;
+
+}  // namespace
+
+FingerData::FingerData(Wsg* wsg, int64_t poll_period_us, int max_samples)
+    : wsg_(wsg),
+      poll_period_us_(poll_period_us),
+      max_samples_(max_samples) {
+  assert(wsg_ != nullptr);
+  assert(max_samples_ > 0);
+}
+
+void FingerData::Initialize() {
+  int max_data_size = 0;
+  for (int i = 0; i < kNumFingers; i++) {
+    info_[i] = wsg_->GetFingerInfo(i);
+    if (info_[i].type_ == kFingerNotConnected) { continue; }
+    if (!wsg_->SetFingerPower(i, true)) {
+      std::cerr << "Powering finger " << i << " failed" << std::endl;
+      info_[i].type_ = kFingerNotConnected;
+      continue;
+    }
+    max_data_size = std::max(max_data_size,
+                             static_cast<int>(info_[i].data_size_));
+  }
+
+  // Reserve the full batch up front so that HandleResponse() never
+  // allocates.
+  batch_.sample_utime.reserve(max_samples_);
+  batch_.finger_index.reserve(max_samples_);
+  batch_.finger_type.reserve(max_samples_);
+  batch_.force.reserve(max_samples_);
+  batch_.data_offset.reserve(max_samples_);
+  batch_.data_size.reserve(max_samples_);
+  batch_.data.reserve(max_samples_ * max_data_size);
+  batch_.tactile_offset.reserve(max_samples_);
+  batch_.tactile_size.reserve(max_samples_);
+  batch_.tactile.reserve(max_samples_ * max_data_size / sizeof(int16_t));
+  Clear();
+}
+
+int FingerData::num_active() const {
+  int result = 0;
+  for (int i = 0; i < kNumFingers; i++) {
+    if (IsActive(i)) { result++; }
+  }
+  return result;
+}
+
+bool FingerData::IsActive(int index) const {
+  return info_[index].type_ != kFingerNotConnected &&
+      info_[index].data_size_ > 0;
+}
+
+void FingerData::Poll(int64_t now_utime) {
+  if (outstanding_ >= 0) {
+    if (now_utime - request_utime_ <
+        kRequestTimeoutPeriods * poll_period_us_) {
+      return;
+    }
+    // Assume the request or its response was lost, but give a late
+    // response time to arrive before asking another finger.
+    outstanding_ = -1;
+    quarantine_end_utime_ =
+        now_utime + kRequestTimeoutPeriods * poll_period_us_;
+  }
+  if (now_utime < quarantine_end_utime_) { return; }
+  for (int tries = 0; tries < kNumFingers; tries++) {
+    const int index = next_;
+    next_ = (next_ + 1) % kNumFingers;
+    if (!IsActive(index)) { continue; }
+    if (now_utime - last_poll_utime_[index] < poll_period_us_) { continue; }
+    wsg_->RequestFingerDataNonblocking(index);
+    outstanding_ = index;
+    request_utime_ = now_utime;
+    last_poll_utime_[index] = now_utime;
+    return;
+  }
+}
+
+bool FingerData::HandleResponse(const WsgReturnMessage& msg,
+                                int64_t receive_utime) {
+  if (msg.command() != kGetFingerData) { return false; }
+  const int index = outstanding_;
+  outstanding_ = -1;
+  if (index < 0 || msg.status() != E_SUCCESS) { return true; }
+
+  const std::vector<unsigned char>& params = msg.params();
+  const int size = static_cast<int>(params.size());
+  if (size != info_[index].data_size_) { return true; }  // Not this finger's.
+  float force = 0;
+  if (info_[index].type_ == kFingerForceMeasurement &&
+      size >= static_cast<int>(sizeof(force))) {
+    memcpy(&force, params.data(), sizeof(force));
+    latest_force_[index] = force;
+  }
+
+  if (full()) { return true; }  // Drop rather than grow the batch.
+  batch_.sample_utime.push_back(receive_utime);
+  batch_.finger_index.push_back(static_cast<int8_t>(index));
+  batch_.finger_type.push_back(static_cast<int8_t>(info_[index].type_));
+  batch_.force.push_back(force);
+  batch_.data_offset.push_back(batch_.num_data_bytes);
+  batch_.data_size.push_back(size);
+  batch_.data.insert(batch_.data.end(), params.begin(), params.end());
+  batch_.num_data_bytes += size;
+  const int cells = (info_[index].type_ == kFingerTactile)
+      ? size / static_cast<int>(sizeof(int16_t)) : 0;
+  batch_.tactile_offset.push_back(batch_.num_tactile_cells);
+  batch_.tactile_size.push_back(cells);
+  for (int i = 0; i < cells; i++) {
+    // Little-endian, like all WSG data.
+    batch_.tactile.push_back(static_cast<int16_t>(
+        params[2 * i] | (params[2 * i + 1] << 8)));
+  }
+  batch_.num_tactile_cells += cells;
+  batch_.num_samples++;
+  return true;
+}
+
+const lcmt_schunk_wsg_finger_data& FingerData::Seal(int64_t now_utime) {
+  batch_.utime = now_utime;
+  return batch_;
+}
+
+void FingerData::Clear() {
+  batch_.num_samples = 0;
+  batch_.num_data_bytes = 0;
+  batch_.sample_utime.clear();
+  batch_.finger_index.clear();
+  batch_.finger_type.clear();
+  batch_.force.clear();
+  batch_.data_offset.clear();
+  batch_.data_size.clear();
+  batch_.data.clear();
+  batch_.num_tactile_cells = 0;
+  batch_.tactile_offset.clear();
+  batch_.tactile_size.clear();
+  batch_.tactile.clear();
+}
+
+}  // namespace schunk_driver
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+
+#include "schunk_driver/lcmt_schunk_wsg_finger_data.hpp"
+
+#include "wsg.h"
+#include "wsg_return_message.h"
+
+namespace schunk_driver {
+
+/// Discovers, powers and polls the gripper's smart fingers, and accumulates
+/// their data into an lcmt_schunk_wsg_finger_data batch.
+///
+/// GetFingerData responses do not identify the finger they describe, so the
+/// fingers are polled round-robin with at most one request outstanding, and
+/// a response is credited to the requested finger only if its size is that
+/// finger's data size.  After a request times out, polling pauses for
+/// another timeout so that a late response is discarded rather than
+/// credited to the next finger polled.  Tactile (WSG-DSA) frames are also
+/// decoded into their cell values.  The batch storage is reserved up front
+/// so that decoding never allocates.
+class FingerData {
+ public:
+  static const int kNumFingers = 2;
+
+  /// Polls @p wsg (which must outlive this object) no more often than every
+  /// @p poll_period_us per finger, batching up to @p max_samples samples.
+  FingerData(Wsg* wsg, int64_t poll_period_us, int max_samples);
+
+  /// Discovers the attached fingers and powers on the ones that provide
+  /// data.  This is a blocking command, meant to be run during calibration.
+  void Initialize();
+
+  /// Requests data from the next finger if no request is outstanding and one
+  /// is due.  Does not block.  Call after handling the responses received so
+  /// far, so that an answered request does not hold up the next.
+  void Poll(int64_t now_utime);
+
+  /// Consumes @p msg if it is a GetFingerData response, appending its data to
+  /// the pending batch.  Returns true if @p msg was consumed.
+  bool HandleResponse(const WsgReturnMessage& msg, int64_t receive_utime);
+
+  const FingerInfo& info(int index) const { return info_[index]; }
+
+  /// Number of fingers that provide data.
+  int num_active() const;
+
+  /// The most recent force reported by force measurement finger @p index.
+  float force(int index) const { return latest_force_[index]; }
+
+  bool empty() const { return batch_.num_samples == 0; }
+  bool full() const { return batch_.num_samples >= max_samples_; }
+
+  /// Stamps the pending batch with @p now_utime and returns it for
+  /// publication.  The batch remains pending until Clear() is called.
+  const lcmt_schunk_wsg_finger_data& Seal(int64_t now_utime);
+
+  /// Discards the pending batch without releasing its storage.
+  void Clear();
+
+ private:
+  bool IsActive(int index) const;
+
+  Wsg* const wsg_;
+  const int64_t poll_period_us_;
+  const int max_samples_;
+  FingerInfo info_[kNumFingers];
+  float latest_force_[kNumFingers] {0, 0};
+
+  // The finger whose data was last requested, or -1 if none is outstanding.
+  int outstanding_ {-1};
+  int next_ {0};
+  int64_t request_utime_ {0};
+  // Until this time, no requests are sent and responses are discarded.
+  int64_t quarantine_end_utime_ {0};
+  int64_t last_poll_utime_[kNumFingers] {0, 0};
+
+  lcmt_schunk_wsg_finger_data batch_{};
+};
+
+}  // namespace schunk_driver
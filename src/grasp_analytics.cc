@@ -0,0 +1,273 @@
+/// Computes per-grasp key performance indicators from recorded LCM logs of
+/// the driver's command and status channels, many logs at a time:
+///
+///   grasp_analytics --output=grasps.csv logs/*.lcmlog
+///
+/// Each log is memory-mapped and scanned once, on one of a pool of worker
+/// threads, and split into grasp episodes by GraspEpisodeSegmenter.  Writes
+/// one CSV row per episode and a summary of the whole corpus to stderr.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#include "drake/lcmt_schunk_wsg_command.hpp"
+#include "drake/lcmt_schunk_wsg_status.hpp"
+#include "schunk_driver/lcmt_schunk_wsg_contact_event.hpp"
+#include "schunk_driver/lcmt_schunk_wsg_mode_command.hpp"
+#include "schunk_driver/lcmt_schunk_wsg_status_batch.hpp"
+
+#include "grasp_episodes.h"
+#include "lcm_log_reader.h"
+
+DEFINE_string(status_channel, "SCHUNK_WSG_STATUS",
+              "Channel of lcmt_schunk_wsg_status messages");
+DEFINE_string(status_batch_channel, "",
+              "Channel of lcmt_schunk_wsg_status_batch messages; if set, "
+              "these are used instead of the status channel, for their "
+              "every sample and grasping state");
+DEFINE_string(command_channel, "SCHUNK_WSG_COMMAND",
+              "Channel of lcmt_schunk_wsg_command messages");
+DEFINE_string(mode_command_channel, "SCHUNK_WSG_MODE_COMMAND",
+              "Channel of lcmt_schunk_wsg_mode_command messages");
+DEFINE_string(contact_event_channel, "",
+              "Channel of lcmt_schunk_wsg_contact_event messages, from which "
+              "slips are counted; if empty, slips are not counted");
+DEFINE_double(contact_force, 5,
+              "Force (N) at or above which the fingers are in contact");
+DEFINE_double(release_force, 2,
+              "Force (N) below which contact is broken");
+DEFINE_int32(threads, 0,
+             "Number of worker threads; 0 uses one per hardware thread");
+DEFINE_string(output, "", "CSV file to write; empty writes to stdout");
+
+namespace schunk_driver {
+namespace {
+
+/// The episodes of one log, and what it took to find them.
+struct LogResult {
+  std::vector<GraspEpisode> episodes;
+  uint64_t events {0};
+  uint64_t bytes {0};
+  uint64_t decode_errors {0};
+  std::string error;  //< Non-empty if the log could not be read.
+};
+
+// Decodes @p event into @p message, counting failures.
+template <typename Message>
+bool Decode(const LcmLogEvent& event, Message* message, LogResult* result) {
+  if (message->decode(event.data, 0, event.data_size) < 0) {
+    result->decode_errors++;
+    return false;
+  }
+  return true;
+}
+
+void AnalyzeLog(const std::string& path, LogResult* result) {
+  GraspEpisodeParams params;
+  params.contact_force = FLAGS_contact_force;
+  params.release_force = FLAGS_release_force;
+  GraspEpisodeSegmenter segmenter(params);
+  const bool use_batches = !FLAGS_status_batch_channel.empty();
+  const bool use_contact_events = !FLAGS_contact_event_channel.empty();
+
+  // Decode into the same messages throughout, reusing their storage.
+  drake::lcmt_schunk_wsg_status status;
+  drake::lcmt_schunk_wsg_command command;
+  lcmt_schunk_wsg_mode_command mode_command;
+  lcmt_schunk_wsg_status_batch batch;
+  lcmt_schunk_wsg_contact_event contact_event;
+
+  std::unique_ptr<LcmLogReader> reader;
+  try {
+    reader.reset(new LcmLogReader(path));
+  } catch (const std::runtime_error& e) {
+    result->error = e.what();
+    return;
+  }
+  result->bytes = reader->size();
+  LcmLogEvent event;
+  while (reader->Next(&event)) {
+    result->events++;
+    if (LcmLogReader::OnChannel(event, FLAGS_command_channel)) {
+      if (Decode(event, &command, result)) {
+        segmenter.HandleCommand(event.utime, command.target_position_mm,
+                                std::fabs(command.force));
+      }
+    } else if (LcmLogReader::OnChannel(event, FLAGS_mode_command_channel)) {
+      if (Decode(event, &mode_command, result)) {
+        segmenter.HandleCommand(event.utime, mode_command.target_position_mm,
+                                std::fabs(mode_command.force));
+      }
+    } else if (use_batches) {
+      if (LcmLogReader::OnChannel(event, FLAGS_status_batch_channel) &&
+          Decode(event, &batch, result)) {
+        for (int i = 0; i < batch.num_samples; i++) {
+          segmenter.HandleStatus(batch.sample_utime[i],
+                                 batch.actual_position_mm[i],
+                                 std::fabs(batch.actual_force[i]),
+                                 batch.grasping_state[i]);
+        }
+      }
+    } else if (LcmLogReader::OnChannel(event, FLAGS_status_channel)) {
+      // The driver signs force by the direction of motion; grasps need
+      // only its magnitude.
+      if (Decode(event, &status, result)) {
+        segmenter.HandleStatus(event.utime, status.actual_position_mm,
+                               std::fabs(status.actual_force), -1);
+      }
+    }
+    if (use_contact_events &&
+        LcmLogReader::OnChannel(event, FLAGS_contact_event_channel) &&
+        Decode(event, &contact_event, result)) {
+      if (contact_event.event_type == lcmt_schunk_wsg_contact_event::SLIP) {
+        segmenter.HandleSlip(event.utime);
+      } else if (contact_event.event_type ==
+                 lcmt_schunk_wsg_contact_event::PART_LOST) {
+        segmenter.HandlePartLost(event.utime);
+      }
+    }
+  }
+  result->episodes = segmenter.Finish();
+}
+
+void WriteEpisodes(const std::string& path,
+                   const std::vector<GraspEpisode>& episodes, FILE* out) {
+  for (const GraspEpisode& e : episodes) {
+    fprintf(out, "%s,%ld,%ld,%d,%.3f,%.3f,", path.c_str(),
+            static_cast<long>(e.start_utime), static_cast<long>(e.end_utime),
+            e.complete ? 1 : 0, e.cycle_us * 1e-6,
+            (e.end_utime - e.start_utime) * 1e-6);
+    if (e.contact_utime) {
+      fprintf(out, "%.3f,", (e.contact_utime - e.start_utime) * 1e-6);
+    } else {
+      fprintf(out, ",");
+    }
+    fprintf(out, "%.2f,%.2f,%.2f,%d,%d,%d,%d,%d,%.3f,%.3f,%.3f,%.3f\n",
+            e.target_mm, e.commanded_force, e.contact_width_mm,
+            e.held ? 1 : 0, e.part_lost ? 1 : 0, e.no_part_found ? 1 : 0,
+            e.slips, e.force_samples, e.force_mean, e.force_stddev,
+            e.force_min, e.force_max);
+  }
+}
+
+// The @p fraction quantile of @p values, which it sorts.
+double Quantile(std::vector<double>* values, double fraction) {
+  if (values->empty()) { return 0; }
+  std::sort(values->begin(), values->end());
+  return (*values)[std::min(values->size() - 1,
+                            static_cast<size_t>(fraction * values->size()))];
+}
+
+int DoMain(const std::vector<std::string>& paths) {
+  if (paths.empty()) {
+    std::cerr << "Usage: grasp_analytics [flags] LOG..." << std::endl;
+    return 1;
+  }
+
+  // Each work item is one log; logs are typically one per session, so
+  // there are plenty to keep every thread busy.
+  std::vector<LogResult> results(paths.size());
+  const int num_threads = (FLAGS_threads > 0)
+      ? FLAGS_threads
+      : std::max(1u, std::thread::hardware_concurrency());
+  std::atomic<size_t> next_item(0);
+  const auto wall_start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int i = 0; i < num_threads; i++) {
+    workers.emplace_back([&]() {
+        size_t item;
+        while ((item = next_item++) < paths.size()) {
+          AnalyzeLog(paths[item], &results[item]);
+        }
+      });
+  }
+  for (auto& worker : workers) { worker.join(); }
+  const double wall_s = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - wall_start).count();
+
+  FILE* out = stdout;
+  if (!FLAGS_output.empty()) {
+    out = fopen(FLAGS_output.c_str(), "w");
+    if (!out) {
+      std::cerr << "Could not write " << FLAGS_output << std::endl;
+      return 1;
+    }
+  }
+  fprintf(out, "log,start_utime,end_utime,complete,cycle_s,duration_s,"
+          "time_to_contact_s,target_mm,commanded_force,contact_width_mm,"
+          "held,part_lost,no_part_found,slips,force_samples,force_mean,"
+          "force_stddev,force_min,force_max\n");
+
+  uint64_t events = 0;
+  uint64_t bytes = 0;
+  uint64_t decode_errors = 0;
+  int failed_logs = 0;
+  int complete = 0;
+  int held = 0;
+  int slips = 0;
+  std::vector<double> cycles_s;
+  std::vector<double> held_forces;
+  for (size_t i = 0; i < paths.size(); i++) {
+    const LogResult& result = results[i];
+    if (!result.error.empty()) {
+      std::cerr << result.error << std::endl;
+      failed_logs++;
+      continue;
+    }
+    WriteEpisodes(paths[i], result.episodes, out);
+    events += result.events;
+    bytes += result.bytes;
+    decode_errors += result.decode_errors;
+    for (const GraspEpisode& episode : result.episodes) {
+      slips += episode.slips;
+      if (episode.cycle_us) { cycles_s.push_back(episode.cycle_us * 1e-6); }
+      if (!episode.complete) { continue; }
+      complete++;
+      if (episode.held) {
+        held++;
+        held_forces.push_back(episode.force_mean);
+      }
+    }
+  }
+  if (out != stdout && fclose(out) != 0) {
+    std::cerr << "Could not write " << FLAGS_output << std::endl;
+    return 1;
+  }
+
+  fprintf(stderr, "Read %zu logs (%.1f MB, %lu events) on %d threads in "
+          "%.3fs (%.0f MB/s)\n", paths.size() - failed_logs, bytes / 1e6,
+          static_cast<unsigned long>(events), num_threads, wall_s,
+          bytes / 1e6 / std::max(wall_s, 1e-9));
+  if (decode_errors) {
+    fprintf(stderr, "%lu messages failed to decode\n",
+            static_cast<unsigned long>(decode_errors));
+  }
+  fprintf(stderr, "%d complete grasps, %d held (%.1f%%), %d slips\n",
+          complete, held, complete ? 100.0 * held / complete : 0.0, slips);
+  fprintf(stderr, "cycle time p50 %.3fs p90 %.3fs; "
+          "held force p10 %.1fN p50 %.1fN p90 %.1fN\n",
+          Quantile(&cycles_s, 0.5), Quantile(&cycles_s, 0.9),
+          Quantile(&held_forces, 0.1), Quantile(&held_forces, 0.5),
+          Quantile(&held_forces, 0.9));
+  return failed_logs ? 1 : 0;
+}
+
+}  // namespace
+}  // namespace schunk_driver
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  return schunk_driver::DoMain(
+      std::vector<std::string>(argv + 1, argv + argc));
+}
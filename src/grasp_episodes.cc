@@ -0,0 +1,140 @@
+#include "grasp_episodes.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "wsg_return_message.h"
+
+namespace schunk_driver {
+
+namespace {
+
+// Independent accumulators per reduction in EndEpisode().
+const int kLanes = 4;
+
+}  // namespace
+
+GraspEpisodeSegmenter::GraspEpisodeSegmenter(const GraspEpisodeParams& params)
+    : params_(params) {}
+
+void GraspEpisodeSegmenter::HandleCommand(int64_t utime, double target_mm,
+                                          double force) {
+  last_utime_ = utime;
+  if (position_mm_ < 0) { return; }  // Nothing to compare the target with.
+  if (!closed_ && target_mm < position_mm_ - params_.min_travel_mm) {
+    if (!episodes_.empty()) {
+      episodes_.back().cycle_us = utime - episodes_.back().start_utime;
+    }
+    GraspEpisode episode;
+    episode.start_utime = utime;
+    episode.target_mm = target_mm;
+    episode.commanded_force = force;
+    episodes_.push_back(episode);
+    closed_ = true;
+    in_contact_ = false;
+    forces_.clear();
+  } else if (closed_ && target_mm > position_mm_ + params_.min_travel_mm) {
+    EndEpisode(utime, true);
+  } else if (closed_) {
+    episodes_.back().commanded_force = force;
+  }
+}
+
+void GraspEpisodeSegmenter::HandleStatus(int64_t utime, double position_mm,
+                                         double force, int grasping_state) {
+  position_mm_ = position_mm;
+  last_utime_ = utime;
+  if (!closed_) { return; }
+  GraspEpisode& episode = episodes_.back();
+  bool contact = in_contact_
+      ? (force >= params_.release_force)
+      : (force >= params_.contact_force);
+  if (grasping_state == kHolding) { contact = true; }
+  if (grasping_state == kPartLost) { episode.part_lost = true; }
+  if (grasping_state == kNoPartFound) { episode.no_part_found = true; }
+  if (in_contact_ && !contact) { episode.part_lost = true; }
+  if (contact && episode.contact_utime == 0) {
+    episode.contact_utime = utime;
+    episode.contact_width_mm = position_mm;
+  }
+  in_contact_ = contact;
+  if (contact) { forces_.push_back(force); }
+}
+
+void GraspEpisodeSegmenter::HandleSlip(int64_t utime) {
+  last_utime_ = utime;
+  if (closed_) { episodes_.back().slips++; }
+}
+
+void GraspEpisodeSegmenter::HandlePartLost(int64_t utime) {
+  last_utime_ = utime;
+  if (closed_) { episodes_.back().part_lost = true; }
+}
+
+const std::vector<GraspEpisode>& GraspEpisodeSegmenter::Finish() {
+  if (closed_) { EndEpisode(last_utime_, false); }
+  return episodes_;
+}
+
+void GraspEpisodeSegmenter::EndEpisode(int64_t utime, bool complete) {
+  GraspEpisode& episode = episodes_.back();
+  episode.end_utime = utime;
+  episode.complete = complete;
+  episode.held = in_contact_;
+  closed_ = false;
+  in_contact_ = false;
+
+  // The compiler may not reorder a floating-point reduction itself, so each
+  // pass splits it across kLanes accumulators to break its single
+  // dependency chain.
+  const int n = forces_.size();
+  episode.force_samples = n;
+  if (n == 0) { return; }
+  const double* forces = forces_.data();
+  const int n_lanes = n - n % kLanes;
+  double lane_sum[kLanes] = {};
+  for (int i = 0; i < n_lanes; i += kLanes) {
+    for (int lane = 0; lane < kLanes; lane++) {
+      lane_sum[lane] += forces[i + lane];
+    }
+  }
+  for (int i = n_lanes; i < n; i++) { lane_sum[0] += forces[i]; }
+  double sum = 0;
+  for (int lane = 0; lane < kLanes; lane++) { sum += lane_sum[lane]; }
+  const double mean = sum / n;
+  double lane_squares[kLanes] = {};
+  double lane_min[kLanes];
+  double lane_max[kLanes];
+  for (int lane = 0; lane < kLanes; lane++) {
+    lane_min[lane] = forces[0];
+    lane_max[lane] = forces[0];
+  }
+  for (int i = 0; i < n_lanes; i += kLanes) {
+    for (int lane = 0; lane < kLanes; lane++) {
+      const double force = forces[i + lane];
+      lane_squares[lane] += (force - mean) * (force - mean);
+      lane_min[lane] = std::min(lane_min[lane], force);
+      lane_max[lane] = std::max(lane_max[lane], force);
+    }
+  }
+  for (int i = n_lanes; i < n; i++) {
+    lane_squares[0] += (forces[i] - mean) * (forces[i] - mean);
+    lane_min[0] = std::min(lane_min[0], forces[i]);
+    lane_max[0] = std::max(lane_max[0], forces[i]);
+  }
+  double squares = 0;
+  double min = forces[0];
+  double max = forces[0];
+  for (int lane = 0; lane < kLanes; lane++) {
+    squares += lane_squares[lane];
+    min = std::min(min, lane_min[lane]);
+    max = std::max(max, lane_max[lane]);
+  }
+  episode.force_mean = mean;
+  episode.force_stddev = std::sqrt(squares / n);
+  episode.force_min = min;
+  episode.force_max = max;
+  forces_.clear();
+}
+
+}  // namespace schunk_driver
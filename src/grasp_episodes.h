@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace schunk_driver {
+
+/// Thresholds for GraspEpisodeSegmenter.  Forces are in Newtons, widths in
+/// millimeters of base separation.
+struct GraspEpisodeParams {
+  /// Force at or above which the fingers are considered in contact.
+  double contact_force {5};
+  /// Force below which contact is considered broken (hysteresis).
+  double release_force {2};
+  /// A command target this far inside (outside) the current width closes
+  /// (opens) the fingers; nearer targets do not change the phase.
+  double min_travel_mm {1};
+};
+
+/// One grasp, from the command that closed the fingers to the one that
+/// opened them again, with its key performance indicators.  Times are
+/// microseconds.
+struct GraspEpisode {
+  int64_t start_utime {0};  //< The closing command.
+  int64_t end_utime {0};  //< The opening command, or the last sample.
+  bool complete {false};  //< Whether the fingers were commanded open.
+  /// Time to the start of the next episode in the same log, or zero for the
+  /// last one.
+  int64_t cycle_us {0};
+
+  double target_mm {0};
+  double commanded_force {0};  //< The last force commanded while closed.
+
+  int64_t contact_utime {0};  //< Zero if contact was never made.
+  double contact_width_mm {0};
+
+  /// Whether the part was held (in contact, or reported kHolding) when the
+  /// fingers were commanded open.
+  bool held {false};
+  /// Whether contact was lost, or kPartLost reported, while closed.
+  bool part_lost {false};
+  /// Whether the gripper reported kNoPartFound.
+  bool no_part_found {false};
+  int slips {0};
+
+  /// Statistics of the force over the samples while in contact.
+  int force_samples {0};
+  double force_mean {0};
+  double force_stddev {0};
+  double force_min {0};
+  double force_max {0};
+};
+
+/// Splits one time-ordered stream of gripper commands and status into grasp
+/// episodes.  A command whose target is inside the current width starts an
+/// episode; one outside it ends the episode.  Contact is taken from force
+/// thresholds, and from the gripper's grasping state when the log carries
+/// it; slip from the driver's contact events when the log carries them.
+class GraspEpisodeSegmenter {
+ public:
+  explicit GraspEpisodeSegmenter(const GraspEpisodeParams& params);
+
+  void HandleCommand(int64_t utime, double target_mm, double force);
+
+  /// Handles one status sample; @p grasping_state is a GraspingState, or
+  /// negative if unknown.
+  void HandleStatus(int64_t utime, double position_mm, double force,
+                    int grasping_state);
+
+  void HandleSlip(int64_t utime);
+  void HandlePartLost(int64_t utime);
+
+  /// Closes any episode in progress as incomplete and returns every
+  /// episode, in order.
+  const std::vector<GraspEpisode>& Finish();
+
+ private:
+  void EndEpisode(int64_t utime, bool complete);
+
+  const GraspEpisodeParams params_;
+  std::vector<GraspEpisode> episodes_;
+  bool closed_ {false};
+  bool in_contact_ {false};
+  double position_mm_ {-1};  //< Negative until the first status.
+  int64_t last_utime_ {0};
+  // Forces of the current episode's samples in contact, reduced when it
+  // ends.
+  std::vector<double> forces_;
+};
+
+}  // namespace schunk_driver
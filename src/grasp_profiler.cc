@@ -0,0 +1,138 @@
+#include "grasp_profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace schunk_driver {
+
+GraspProfiler::GraspProfiler(Wsg* wsg, const GraspProfilerParams& params,
+                             Listener listener)
+    : wsg_(wsg),
+      params_(params),
+      listener_(std::move(listener)) {}
+
+void GraspProfiler::SetTarget(int64_t now_us, double position_mm,
+                              double force, int control_mode) {
+  const bool new_target =
+      !has_target_ || control_mode != episode_.control_mode ||
+      std::fabs(position_mm - episode_.target_position_mm) >=
+      params_.new_target_mm;
+  if (!new_target) {
+    if (open_) { episode_.target_force = force; }
+    return;
+  }
+  if (open_) { EndEpisode(now_us, false); }
+  has_target_ = true;
+  open_ = true;
+  episode_ = GraspProfile();
+  episode_.start_utime = now_us;
+  episode_.target_position_mm = position_mm;
+  episode_.target_force = force;
+  episode_.control_mode = control_mode;
+  start_counts_ = CountCommands();
+  slow_since_utime_ = 0;
+}
+
+void GraspProfiler::HandleStatus(int64_t utime, double position_mm,
+                                 double speed_mm_per_s, double force,
+                                 GraspingState grasping_state) {
+  // Samples taken before the target was commanded say nothing about it.
+  if (!open_ || utime < episode_.start_utime) { return; }
+  const int64_t elapsed_us = utime - episode_.start_utime;
+  episode_.final_position_mm = position_mm;
+  episode_.final_grasping_state = grasping_state;
+  episode_.peak_force = std::max(episode_.peak_force, std::fabs(force));
+  if (episode_.time_to_contact_us < 0 &&
+      (std::fabs(force) >= params_.contact_force ||
+       grasping_state == kHolding)) {
+    episode_.time_to_contact_us = elapsed_us;
+  }
+  if (episode_.time_to_holding_us < 0 && grasping_state == kHolding) {
+    episode_.time_to_holding_us = elapsed_us;
+  }
+  if (std::fabs(speed_mm_per_s) >= params_.settled_speed_mm_per_s) {
+    slow_since_utime_ = 0;
+  } else if (slow_since_utime_ == 0) {
+    slow_since_utime_ = utime;
+  } else if (utime - slow_since_utime_ >= params_.settle_time_us) {
+    EndEpisode(utime, true);
+  }
+}
+
+void GraspProfiler::Poll(int64_t now_us) {
+  for (Pending& pending : pending_) {
+    if (pending.request_utime == 0) {
+      // Report the lifetime counters without resetting them.
+      wsg_->Send(WsgCommandMessage(kGetGraspStats, {0}));
+      pending.request_utime = now_us;
+    }
+  }
+  while (!pending_.empty() &&
+         now_us - pending_.front().request_utime >= params_.stats_timeout_us) {
+    listener_(pending_.front().profile);
+    expired_request_utimes_.push_back(pending_.front().request_utime);
+    pending_.pop_front();
+  }
+  // A response this late is taken to be lost.
+  while (!expired_request_utimes_.empty() &&
+         now_us - expired_request_utimes_.front() >=
+         2 * params_.stats_timeout_us) {
+    expired_request_utimes_.pop_front();
+  }
+}
+
+bool GraspProfiler::HandleResponse(const WsgReturnMessage& msg) {
+  if (msg.command() != kGetGraspStats) { return false; }
+  // Responses carry nothing to match them to requests, which the gripper
+  // answers in order, so a response belongs to the oldest request still
+  // outstanding: first those already reported without it.
+  if (!expired_request_utimes_.empty()) {
+    expired_request_utimes_.pop_front();
+    return true;
+  }
+  if (pending_.empty() || pending_.front().request_utime == 0) {
+    return true;
+  }
+  GraspProfile& profile = pending_.front().profile;
+  if (msg.status() == E_SUCCESS && msg.params().size() >= 8) {
+    uint32_t total;
+    uint16_t no_part_found;
+    uint16_t part_lost;
+    memcpy(&total, msg.params().data(), sizeof(total));
+    memcpy(&no_part_found, msg.params().data() + 4, sizeof(no_part_found));
+    memcpy(&part_lost, msg.params().data() + 6, sizeof(part_lost));
+    profile.firmware_grasps = total;
+    profile.firmware_no_part_found = no_part_found;
+    profile.firmware_part_lost = part_lost;
+  }
+  listener_(profile);
+  pending_.pop_front();
+  return true;
+}
+
+GraspProfiler::CommandCounts GraspProfiler::CountCommands() const {
+  CommandCounts counts;
+  counts.prepositions = wsg_->sent(kPrePosition);
+  counts.force_limits = wsg_->sent(kSetForceLimit);
+  counts.grasps = wsg_->sent(kGrasp);
+  counts.releases = wsg_->sent(kRelease);
+  return counts;
+}
+
+void GraspProfiler::EndEpisode(int64_t utime, bool settled) {
+  const CommandCounts counts = CountCommands();
+  episode_.end_utime = utime;
+  episode_.settled = settled;
+  episode_.prepositions = counts.prepositions - start_counts_.prepositions;
+  episode_.force_limits = counts.force_limits - start_counts_.force_limits;
+  episode_.grasps = counts.grasps - start_counts_.grasps;
+  episode_.releases = counts.releases - start_counts_.releases;
+  open_ = false;
+  Pending pending;
+  pending.profile = episode_;
+  pending_.push_back(pending);
+}
+
+}  // namespace schunk_driver
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+#include "wsg.h"
+#include "wsg_return_message.h"
+
+namespace schunk_driver {
+
+/// Thresholds for GraspProfiler.  Forces are in Newtons, widths in
+/// millimeters of base separation.
+struct GraspProfilerParams {
+  /// Force at or above which the fingers are considered in contact.
+  double contact_force {5};
+  /// A target at least this far from the current episode's starts a new
+  /// episode; nearer ones (eg regrip force changes) continue it.
+  double new_target_mm {1};
+  /// An episode ends once the fingers have moved slower than this...
+  double settled_speed_mm_per_s {1};
+  /// ...for this long.
+  int64_t settle_time_us {100000};
+  /// Time to wait for the firmware's grasp statistics at the end of an
+  /// episode before reporting it without them.
+  int64_t stats_timeout_us {100000};
+};
+
+/// How the gripper performed over one episode: from a new target until the
+/// fingers settled or the next new target.  Times are microseconds.
+struct GraspProfile {
+  int64_t start_utime {0};  //< When the target was first commanded.
+  int64_t end_utime {0};
+  double target_position_mm {0};
+  double target_force {0};  //< The last force commanded.
+  int control_mode {0};  //< A PositionForceControl::ControlMode.
+  /// Whether the fingers settled, rather than a new target intervening.
+  bool settled {false};
+
+  /// Times from the start to the first sample in contact and reporting
+  /// kHolding, or -1 if there was none.
+  int64_t time_to_contact_us {-1};
+  int64_t time_to_holding_us {-1};
+  double final_position_mm {0};
+  double peak_force {0};
+  GraspingState final_grasping_state {kIdle};
+
+  /// Commands sent over the episode.
+  int prepositions {0};
+  int force_limits {0};
+  int grasps {0};
+  int releases {0};
+
+  /// The firmware's lifetime grasp counters (see kGetGraspStats) read just
+  /// after the episode, so possibly including a grasp that the next episode
+  /// began with, or -1 if it did not report them in time.
+  int64_t firmware_grasps {-1};
+  int64_t firmware_no_part_found {-1};
+  int64_t firmware_part_lost {-1};
+};
+
+/// Splits control into episodes as targets are commanded and status
+/// arrives, and summarizes each one, so that performance and wear can be
+/// watched without recording full-rate status.  When an episode ends its
+/// summary waits for the firmware's grasp statistics, which are requested
+/// from Poll() rather than immediately, so that the request is never held
+/// back with a staged command.
+class GraspProfiler {
+ public:
+  typedef std::function<void(const GraspProfile&)> Listener;
+
+  /// Profiles the commands sent to @p wsg (which must outlive this object),
+  /// calling @p listener with each completed summary.
+  GraspProfiler(Wsg* wsg, const GraspProfilerParams& params,
+                Listener listener);
+
+  /// Notes the target commanded at @p now_us, ending the current episode
+  /// and starting another if it is a new one.
+  void SetTarget(int64_t now_us, double position_mm, double force,
+                 int control_mode);
+
+  /// Updates the current episode with a status sample acquired at
+  /// @p utime, ending it if the fingers have settled.
+  void HandleStatus(int64_t utime, double position_mm, double speed_mm_per_s,
+                    double force, GraspingState grasping_state);
+
+  /// Requests grasp statistics for ended episodes, and reports those whose
+  /// statistics are overdue without them.  Does not block.  Call this after
+  /// handling every pending response, lest one be deemed overdue.
+  void Poll(int64_t now_us);
+
+  /// Consumes @p msg if it is a grasp statistics response, reporting the
+  /// oldest episode awaiting it.  Returns true if @p msg was consumed.
+  bool HandleResponse(const WsgReturnMessage& msg);
+
+ private:
+  // The motion commands counted in GraspProfile.
+  struct CommandCounts {
+    uint64_t prepositions {0};
+    uint64_t force_limits {0};
+    uint64_t grasps {0};
+    uint64_t releases {0};
+  };
+
+  // An ended episode awaiting its grasp statistics.
+  struct Pending {
+    GraspProfile profile;
+    int64_t request_utime {0};  //< Zero until requested.
+  };
+
+  CommandCounts CountCommands() const;
+  void EndEpisode(int64_t utime, bool settled);
+
+  Wsg* const wsg_;
+  const GraspProfilerParams params_;
+  const Listener listener_;
+
+  // The current episode, if open_.
+  bool open_ {false};
+  GraspProfile episode_;
+  CommandCounts start_counts_;
+  int64_t slow_since_utime_ {0};  //< Zero while moving.
+  bool has_target_ {false};  //< Whether any target has been commanded.
+
+  std::deque<Pending> pending_;
+  // When each request whose episode was reported without statistics was
+  // sent, so that its late response is dropped rather than credited to the
+  // next episode.  Forgotten after a second timeout.
+  std::deque<int64_t> expired_request_utimes_;
+};
+
+}  // namespace schunk_driver
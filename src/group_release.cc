@@ -0,0 +1,33 @@
+#include "group_release.h"
+
+#include <algorithm>
+
+namespace schunk_driver {
+
+bool GroupSkewTracker::Add(const GroupRelease& release, GroupSkew* skew) {
+  if (grippers_.empty() || release.group_id != group_id_) {
+    group_id_ = release.group_id;
+    grippers_.clear();
+    complete_ = false;
+    earliest_ns_ = release.send_ns;
+    latest_ns_ = release.send_ns;
+  }
+  if (complete_ ||
+      std::find(grippers_.begin(), grippers_.end(), release.gripper) !=
+      grippers_.end()) {
+    return false;
+  }
+  grippers_.push_back(release.gripper);
+  earliest_ns_ = std::min(earliest_ns_, release.send_ns);
+  latest_ns_ = std::max(latest_ns_, release.send_ns);
+  if (static_cast<int>(grippers_.size()) < release.num_grippers) {
+    return false;
+  }
+  skew->num_grippers = grippers_.size();
+  skew->skew_ns = latest_ns_ - earliest_ns_;
+  skew->max_lateness_ns = latest_ns_ - release.release_ns;
+  complete_ = true;
+  return true;
+}
+
+}  // namespace schunk_driver
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace schunk_driver {
+
+/// One driver's report of having sent its part of a group command.  Times
+/// are on Clock::MonotonicNs(), which unlike the wall clock is never stepped,
+/// and which every process on a host reads the same, so drivers on one host
+/// agree on it exactly.
+struct GroupRelease {
+  int64_t group_id {0};
+  std::string gripper;
+  int num_grippers {0};  //< Grippers addressed by the group command.
+  int64_t release_ns {0};
+  int64_t send_ns {0};
+};
+
+/// How nearly together the drivers of one group command sent it.
+struct GroupSkew {
+  int num_grippers {0};
+  int64_t skew_ns {0};  //< Latest send less earliest.
+  int64_t max_lateness_ns {0};  //< Latest send less the release time.
+};
+
+/// Gathers the reports of the drivers addressed by a group command until
+/// every one has reported, to measure its inter-gripper skew.  Tracks one
+/// group at a time: a report for a new group forgets the last, whether or
+/// not it was complete.
+class GroupSkewTracker {
+ public:
+  /// Records @p release, ignoring repeated reports from one gripper.
+  /// Returns true, filling @p skew, if it completes its group.
+  bool Add(const GroupRelease& release, GroupSkew* skew);
+
+ private:
+  int64_t group_id_ {0};
+  std::vector<std::string> grippers_;  //< Those reported so far.
+  bool complete_ {false};
+  int64_t earliest_ns_ {0};
+  int64_t latest_ns_ {0};
+};
+
+}  // namespace schunk_driver
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "clock.h"
+#include "wsg_simulator.h"
+#include "wsg_transport.h"
+
+namespace schunk_driver {
+
+/// Connects a Wsg directly to a WsgSimulator in the same process, stamping
+/// messages with times from a shared clock.  The clock's stepper is expected
+/// to call WsgSimulator::Step().
+class InProcessTransport : public WsgTransport {
+ public:
+  /// @p simulator and @p clock must outlive this object.
+  InProcessTransport(WsgSimulator* simulator, Clock* clock)
+      : simulator_(simulator),
+        clock_(clock) {
+  }
+
+  void Send(const WsgCommandMessage& msg) override {
+    simulator_->HandleCommand(msg, clock_->NowNs());
+  }
+
+  std::unique_ptr<WsgReturnMessage> Receive() override {
+    const int64_t now_ns = clock_->NowNs();
+    std::unique_ptr<WsgReturnMessage> result =
+        simulator_->TakeResponse(now_ns);
+    if (result) {
+      result->set_receive_time_ns(now_ns);
+    }
+    return result;
+  }
+
+ private:
+  WsgSimulator* const simulator_;
+  Clock* const clock_;
+};
+
+}  // namespace schunk_driver
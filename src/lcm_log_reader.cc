@@ -0,0 +1,121 @@
+#include "lcm_log_reader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace schunk_driver {
+
+namespace {
+
+const uint32_t kSyncWord = 0xEDA1DA01;
+// Sync word, event number, timestamp, channel length and data length.
+const size_t kHeaderSize = 4 + 8 + 8 + 4 + 4;
+// lcm-logger refuses longer channel names.
+const int32_t kMaxChannelSize = 256;
+
+// Log headers are big-endian.
+uint64_t ReadBigEndian(const unsigned char* data, int size) {
+  uint64_t value = 0;
+  for (int i = 0; i < size; i++) {
+    value = (value << 8) | data[i];
+  }
+  return value;
+}
+
+// Whether a sync word starts anywhere in [@p begin, @p end).
+bool HasSyncWord(const unsigned char* begin, const unsigned char* end) {
+  const unsigned char first = kSyncWord >> 24;
+  while (end - begin >= 4) {
+    begin = static_cast<const unsigned char*>(
+        memchr(begin, first, end - begin - 3));
+    if (!begin) { return false; }
+    if (ReadBigEndian(begin, 4) == kSyncWord) { return true; }
+    begin++;
+  }
+  return false;
+}
+
+}  // namespace
+
+LcmLogReader::LcmLogReader(const std::string& path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Could not open " + path + ": " +
+                             strerror(errno));
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    const std::string error = strerror(errno);
+    close(fd);
+    throw std::runtime_error("Could not stat " + path + ": " + error);
+  }
+  size_ = info.st_size;
+  if (size_ > 0) {
+    void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      const std::string error = strerror(errno);
+      close(fd);
+      throw std::runtime_error("Could not map " + path + ": " + error);
+    }
+    // Logs are read once, front to back.
+    madvise(mapped, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const unsigned char*>(mapped);
+  }
+  close(fd);
+}
+
+LcmLogReader::~LcmLogReader() {
+  if (data_) {
+    munmap(const_cast<unsigned char*>(data_), size_);
+  }
+}
+
+bool LcmLogReader::Next(LcmLogEvent* event) {
+  while (offset_ + kHeaderSize <= size_) {
+    const unsigned char* header = data_ + offset_;
+    const int32_t channel_size = ReadBigEndian(header + 20, 4);
+    const int32_t data_size = ReadBigEndian(header + 24, 4);
+    if (ReadBigEndian(header, 4) != kSyncWord ||
+        channel_size <= 0 || channel_size > kMaxChannelSize ||
+        data_size < 0) {
+      offset_++;
+      bytes_skipped_++;
+      continue;
+    }
+    const size_t event_size = kHeaderSize + channel_size + data_size;
+    if (offset_ + event_size > size_) {
+      // Only the last event of a log can be cut short; before that, this
+      // header is corrupt and only looks valid.
+      if (!HasSyncWord(header + 1, data_ + size_)) {
+        break;  // Truncated.
+      }
+      offset_++;
+      bytes_skipped_++;
+      continue;
+    }
+    event->event_number = ReadBigEndian(header + 4, 8);
+    event->utime = ReadBigEndian(header + 12, 8);
+    event->channel = reinterpret_cast<const char*>(header + kHeaderSize);
+    event->channel_size = channel_size;
+    event->data = header + kHeaderSize + channel_size;
+    event->data_size = data_size;
+    offset_ += event_size;
+    return true;
+  }
+  offset_ = size_;
+  return false;
+}
+
+bool LcmLogReader::OnChannel(const LcmLogEvent& event,
+                             const std::string& channel) {
+  return channel.size() == static_cast<size_t>(event.channel_size) &&
+      memcmp(channel.data(), event.channel, channel.size()) == 0;
+}
+
+}  // namespace schunk_driver
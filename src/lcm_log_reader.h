@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace schunk_driver {
+
+/// One event of an LCM log, as a view into the mapped file.
+struct LcmLogEvent {
+  int64_t event_number {0};
+  int64_t utime {0};  //< Time at which the logger received the message.
+  const char* channel {nullptr};
+  int32_t channel_size {0};
+  const void* data {nullptr};
+  int32_t data_size {0};
+};
+
+/// Reads the events of an LCM event log (as written by lcm-logger) from a
+/// read-only memory mapping, without copying them.  A log cut short, eg by a
+/// crash of the logger, ends at its last complete event; a corrupt event
+/// header, including one whose event would run past the end of a log that
+/// has a later sync word, is skipped by scanning for the next sync word.
+class LcmLogReader {
+ public:
+  /// Maps the log at @p path.  Throws std::runtime_error on failure.
+  explicit LcmLogReader(const std::string& path);
+
+  ~LcmLogReader();
+
+  LcmLogReader(const LcmLogReader&) = delete;
+  LcmLogReader& operator=(const LcmLogReader&) = delete;
+
+  /// Points @p event at the next event, which remains valid for the life of
+  /// this reader.  Returns false at the end of the log.
+  bool Next(LcmLogEvent* event);
+
+  /// Whether @p event is on channel @p channel.
+  static bool OnChannel(const LcmLogEvent& event, const std::string& channel);
+
+  size_t size() const { return size_; }
+  /// Bytes skipped while resynchronizing after corrupt headers.
+  size_t bytes_skipped() const { return bytes_skipped_; }
+
+ private:
+  const unsigned char* data_ {nullptr};
+  size_t size_ {0};
+  size_t offset_ {0};
+  size_t bytes_skipped_ {0};
+};
+
+}  // namespace schunk_driver
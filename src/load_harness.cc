@@ -0,0 +1,382 @@
+/// Runs schunk_driver as a child process against a FakeWsgServer on the
+/// local host, drives it with LCM command traffic up to a command storm, and
+/// checks what reaches the (simulated) wire against a baseline:
+///
+///  * command_latency_ms: time from an LCM step command being published to
+///    the first motion command for it arriving at the gripper.
+///  * status_age_ms: time from the gripper taking a status sample (its
+///    acquisition_utime in the batched status) to the harness receiving it.
+///  * status_gap_ms: time between consecutive status messages.
+///  * driver_cpu_percent: CPU time consumed by the driver process.
+///  * gripper_commands_per_lcm_command: motion commands sent to the gripper
+///    per LCM command published.
+///
+/// Each line of the baseline file names a metric and the maximum value it
+/// may take; the harness exits nonzero if any metric exceeds its baseline.
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <math.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gflags/gflags.h>
+#include <lcm/lcm-cpp.hpp>
+
+#include "drake/lcmt_schunk_wsg_command.hpp"
+#include "drake/lcmt_schunk_wsg_status.hpp"
+#include "schunk_driver/lcmt_schunk_wsg_status_batch.hpp"
+
+#include "clock.h"
+#include "fake_wsg_server.h"
+#include "wsg_command_message.h"
+
+DEFINE_string(driver, "src/schunk_driver", "Path to the driver binary");
+DEFINE_string(baseline, "src/load_harness_baseline.txt",
+              "File of metric names and maximum values; empty to only "
+              "report");
+DEFINE_int32(gripper_port, 21000, "UDP port of the fake gripper");
+DEFINE_int32(local_port, 21001, "UDP port of the driver");
+DEFINE_double(startup_timeout_s, 10,
+              "Time allowed for the driver to begin publishing status");
+DEFINE_int32(num_steps, 20, "Number of step commands");
+DEFINE_int32(step_period_ms, 500, "Time between step commands");
+DEFINE_string(storm_rates_hz, "100,1000,10000",
+              "Comma-separated LCM command rates for the sine storm phases");
+DEFINE_double(storm_duration_s, 3, "Duration of each storm phase");
+DEFINE_double(sine_frequency_hz, 0.5, "Frequency of the storm's sine target");
+
+namespace schunk_driver {
+namespace {
+
+const double kLowTargetMm = 20;
+const double kHighTargetMm = 80;
+const double kCommandForce = 40;
+
+bool IsMotionCommand(int command) {
+  return command == kPrePosition || command == kGrasp ||
+      command == kRelease || command == kStop || command == kFastStop;
+}
+
+double Percentile(std::vector<double> values, double fraction) {
+  if (values.empty()) { return 0; }
+  std::sort(values.begin(), values.end());
+  const size_t index = std::min(
+      values.size() - 1, static_cast<size_t>(fraction * values.size()));
+  return values[index];
+}
+
+// Total user and system CPU time of process @p pid, in seconds.
+double ProcessCpuSeconds(pid_t pid) {
+  std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+  std::string contents;
+  std::getline(stat, contents);
+  // Skip past the parenthesized command name, which may contain spaces;
+  // utime and stime are then the 12th and 13th fields.
+  std::istringstream fields(contents.substr(contents.rfind(')') + 2));
+  std::string field;
+  long ticks = 0;
+  for (int i = 0; i < 13 && fields >> field; i++) {
+    if (i >= 11) { ticks += std::stol(field); }
+  }
+  return static_cast<double>(ticks) / sysconf(_SC_CLK_TCK);
+}
+
+std::map<std::string, double> ReadBaseline(const std::string& path) {
+  std::map<std::string, double> result;
+  std::ifstream in(path);
+  if (!in) {
+    std::cerr << "Could not read baseline " << path << std::endl;
+    return result;
+  }
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') { continue; }
+    std::istringstream words(line);
+    std::string name;
+    double value;
+    if (words >> name >> value) { result[name] = value; }
+  }
+  return result;
+}
+
+/// Publishes commands to, and collects status from, one running driver.
+class LoadHarness {
+ public:
+  LoadHarness(FakeWsgServer* server, pid_t driver_pid,
+              const std::string& command_channel,
+              const std::string& status_channel,
+              const std::string& status_batch_channel)
+      : server_(server), driver_pid_(driver_pid),
+        command_channel_(command_channel), clock_(SystemClock::Get()) {
+    assert(lcm_.good());
+    lcm_.subscribe(status_channel, &LoadHarness::HandleStatus, this);
+    lcm_.subscribe(status_batch_channel, &LoadHarness::HandleStatusBatch,
+                   this);
+  }
+
+  /// Waits up to @p timeout_s for the first status message.
+  bool AwaitStatus(double timeout_s) {
+    const int64_t deadline_ns = clock_->NowNs() + timeout_s * 1e9;
+    while (status_count_ == 0 && clock_->NowNs() < deadline_ns) {
+      lcm_.handleTimeout(100);
+    }
+    return status_count_ > 0;
+  }
+
+  /// Starts the first measurement phase, discarding the commands sent
+  /// during driver startup.
+  void BeginPhases() {
+    server_->TakeCommandLog();
+    ReportPhase();
+  }
+
+  /// Alternates the target between two widths, measuring the latency of
+  /// each step to the wire.
+  void RunSteps(int num_steps, int64_t period_ns) {
+    std::cout << "steps: " << num_steps << std::endl;
+    for (int i = 0; i < num_steps; i++) {
+      const int64_t publish_ns = clock_->NowNs();
+      Publish(i % 2 ? kLowTargetMm : kHighTargetMm);
+      HandleUntil(publish_ns + period_ns);
+      for (const auto& record : TakeMotionCommands()) {
+        if (record.receive_ns >= publish_ns) {
+          command_latency_ms_.push_back(
+              (record.receive_ns - publish_ns) / 1e6);
+          break;
+        }
+      }
+    }
+    ReportPhase();
+  }
+
+  /// Publishes a sine target at @p rate_hz for @p duration_s.
+  void RunStorm(double rate_hz, double duration_s, double frequency_hz) {
+    std::cout << "storm: " << rate_hz << " Hz" << std::endl;
+    const int64_t period_ns = 1e9 / rate_hz;
+    const int64_t start_ns = clock_->NowNs();
+    const int64_t end_ns = start_ns + duration_s * 1e9;
+    for (int64_t next_ns = start_ns; next_ns < end_ns; next_ns += period_ns) {
+      const double t = (next_ns - start_ns) / 1e9;
+      Publish((kLowTargetMm + kHighTargetMm) / 2 +
+              (kHighTargetMm - kLowTargetMm) / 2 *
+              sin(2 * M_PI * frequency_hz * t));
+      HandleUntil(next_ns + period_ns);
+    }
+    TakeMotionCommands();
+    ReportPhase();
+  }
+
+  /// Prints every metric, checks each against @p baseline, and returns
+  /// whether all passed.
+  bool Evaluate(const std::map<std::string, double>& baseline) {
+    std::map<std::string, double> metrics;
+    metrics["command_latency_ms_p50"] = Percentile(command_latency_ms_, 0.5);
+    metrics["command_latency_ms_p99"] = Percentile(command_latency_ms_, 0.99);
+    metrics["status_age_ms_p50"] = Percentile(status_age_ms_, 0.5);
+    metrics["status_age_ms_p99"] = Percentile(status_age_ms_, 0.99);
+    metrics["status_gap_ms_p99"] = Percentile(status_gap_ms_, 0.99);
+    metrics["driver_cpu_percent"] = max_cpu_percent_;
+    metrics["gripper_commands_per_lcm_command"] = max_commands_per_command_;
+    // A step that never reached the wire has no latency to measure.
+    metrics["missed_steps"] = FLAGS_num_steps - command_latency_ms_.size();
+
+    bool pass = true;
+    for (const auto& metric : metrics) {
+      auto limit = baseline.find(metric.first);
+      const bool ok = (limit == baseline.end() ||
+                       metric.second <= limit->second);
+      pass = pass && ok;
+      printf("%-36s %10.3f", metric.first.c_str(), metric.second);
+      if (limit != baseline.end()) {
+        printf("  (max %.3f) %s", limit->second, ok ? "ok" : "FAIL");
+      }
+      printf("\n");
+    }
+    return pass;
+  }
+
+ private:
+  void HandleStatus(const lcm::ReceiveBuffer* rbuf, const std::string& chan,
+                    const drake::lcmt_schunk_wsg_status* status) {
+    const int64_t now_us = clock_->NowUtime();
+    if (status_count_ > 0) {
+      status_gap_ms_.push_back((now_us - last_status_us_) / 1e3);
+    }
+    last_status_us_ = now_us;
+    status_count_++;
+  }
+
+  // The status message's utime is only its publication time, so ages are
+  // taken from the samples themselves.
+  void HandleStatusBatch(const lcm::ReceiveBuffer* rbuf,
+                         const std::string& chan,
+                         const lcmt_schunk_wsg_status_batch* batch) {
+    const int64_t now_us = clock_->NowUtime();
+    for (int i = 0; i < batch->num_samples; i++) {
+      status_age_ms_.push_back((now_us - batch->acquisition_utime[i]) / 1e3);
+    }
+  }
+
+  void Publish(double target_mm) {
+    drake::lcmt_schunk_wsg_command command{};
+    command.utime = clock_->NowUtime();
+    command.target_position_mm = target_mm;
+    command.force = kCommandForce;
+    lcm_.publish(command_channel_, &command);
+    phase_lcm_commands_++;
+  }
+
+  // Handles status messages until @p deadline_ns.
+  void HandleUntil(int64_t deadline_ns) {
+    int64_t now_ns;
+    while ((now_ns = clock_->NowNs()) < deadline_ns) {
+      const int timeout_ms = (deadline_ns - now_ns) / 1000000;
+      if (timeout_ms > 0) {
+        lcm_.handleTimeout(timeout_ms);
+      } else {
+        while (lcm_.handleTimeout(0) > 0) {}
+        clock_->SleepForNs(deadline_ns - now_ns);
+      }
+    }
+  }
+
+  std::vector<FakeWsgServer::CommandRecord> TakeMotionCommands() {
+    std::vector<FakeWsgServer::CommandRecord> result;
+    for (const auto& record : server_->TakeCommandLog()) {
+      if (IsMotionCommand(record.command)) { result.push_back(record); }
+    }
+    phase_gripper_commands_ += result.size();
+    return result;
+  }
+
+  // Records CPU use and the command ratio since the previous phase.
+  void ReportPhase() {
+    const int64_t now_ns = clock_->NowNs();
+    const double cpu_s = ProcessCpuSeconds(driver_pid_);
+    if (phase_start_ns_ > 0) {
+      const double cpu_percent = 100 * (cpu_s - phase_start_cpu_s_) /
+          ((now_ns - phase_start_ns_) / 1e9);
+      const double ratio = static_cast<double>(phase_gripper_commands_) /
+          std::max(phase_lcm_commands_, 1L);
+      printf("  %ld lcm commands, %ld gripper commands, driver cpu %.1f%%\n",
+             phase_lcm_commands_, phase_gripper_commands_, cpu_percent);
+      max_cpu_percent_ = std::max(max_cpu_percent_, cpu_percent);
+      max_commands_per_command_ = std::max(max_commands_per_command_, ratio);
+    }
+    phase_start_ns_ = now_ns;
+    phase_start_cpu_s_ = cpu_s;
+    phase_lcm_commands_ = 0;
+    phase_gripper_commands_ = 0;
+  }
+
+ private:
+  lcm::LCM lcm_;
+  FakeWsgServer* const server_;
+  const pid_t driver_pid_;
+  const std::string command_channel_;
+  Clock* const clock_;
+
+  long status_count_ {0};
+  int64_t last_status_us_ {0};
+  std::vector<double> status_age_ms_;
+  std::vector<double> status_gap_ms_;
+  std::vector<double> command_latency_ms_;
+
+  int64_t phase_start_ns_ {0};
+  double phase_start_cpu_s_ {0};
+  long phase_lcm_commands_ {0};
+  long phase_gripper_commands_ {0};
+  double max_cpu_percent_ {0};
+  double max_commands_per_command_ {0};
+};
+
+pid_t StartDriver(const std::vector<std::string>& args) {
+  const pid_t pid = fork();
+  if (pid == 0) {
+    std::vector<char*> argv;
+    for (const auto& arg : args) {
+      argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    execv(argv[0], argv.data());
+    std::cerr << "Could not run " << args[0] << std::endl;
+    _exit(127);
+  }
+  assert(pid > 0);
+  return pid;
+}
+
+int Run() {
+  // Private channels keep concurrent runs, and any real driver, apart.
+  const std::string suffix = "_LOAD_HARNESS_" + std::to_string(getpid());
+  const std::string command_channel = "SCHUNK_WSG_COMMAND" + suffix;
+  const std::string status_channel = "SCHUNK_WSG_STATUS" + suffix;
+  const std::string status_batch_channel =
+      "SCHUNK_WSG_STATUS_BATCH" + suffix;
+
+  FakeWsgServer server(WsgSimulatorParams(), FLAGS_gripper_port,
+                       FLAGS_local_port);
+  server.Start();
+  const pid_t driver_pid = StartDriver({
+      FLAGS_driver,
+      "--gripper_addr=127.0.0.1",
+      "--gripper_port=" + std::to_string(FLAGS_gripper_port),
+      "--local_port=" + std::to_string(FLAGS_local_port),
+      "--lcm_command_channel=" + command_channel,
+      "--lcm_mode_command_channel=SCHUNK_WSG_MODE_COMMAND" + suffix,
+      "--lcm_group_command_channel=SCHUNK_WSG_GROUP_COMMAND" + suffix,
+      "--lcm_group_release_channel=SCHUNK_WSG_GROUP_RELEASE" + suffix,
+      "--lcm_status_channel=" + status_channel,
+      // Batches of one are published as each sample is handled.
+      "--lcm_status_batch_channel=" + status_batch_channel,
+      "--status_batch_size=1",
+      "--lcm_link_stats_channel=SCHUNK_WSG_LINK_STATS" + suffix});
+
+  bool pass = false;
+  {
+    LoadHarness harness(&server, driver_pid, command_channel, status_channel,
+                        status_batch_channel);
+    if (!harness.AwaitStatus(FLAGS_startup_timeout_s)) {
+      std::cerr << "No status from driver" << std::endl;
+    } else {
+      harness.BeginPhases();
+      harness.RunSteps(FLAGS_num_steps, FLAGS_step_period_ms * 1000000L);
+      std::istringstream rates(FLAGS_storm_rates_hz);
+      std::string rate;
+      while (std::getline(rates, rate, ',')) {
+        harness.RunStorm(std::stod(rate), FLAGS_storm_duration_s,
+                         FLAGS_sine_frequency_hz);
+      }
+      std::map<std::string, double> baseline;
+      if (!FLAGS_baseline.empty()) {
+        baseline = ReadBaseline(FLAGS_baseline);
+      }
+      pass = harness.Evaluate(baseline);
+    }
+  }
+
+  kill(driver_pid, SIGTERM);
+  waitpid(driver_pid, nullptr, 0);
+  server.Stop();
+  std::cout << (pass ? "PASS" : "FAIL") << std::endl;
+  return pass ? 0 : 1;
+}
+
+}  // namespace
+}  // namespace schunk_driver
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  return schunk_driver::Run();
+}
@@ -0,0 +1,177 @@
+/// Runs many grasp scenarios against simulated grippers, each in lockstep
+/// with its own simulated clock, in parallel across all cores.  Each
+/// scenario runs schunk_driver's own SchunkLcmClient and loop period, but
+/// over an in-process LCM and exchanging messages with a WsgSimulator
+/// in-process, so simulated seconds take milliseconds.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <lcm/lcm-cpp.hpp>
+
+#include "drake/lcmt_schunk_wsg_status.hpp"
+#include "schunk_driver/lcmt_schunk_wsg_mode_command.hpp"
+
+#include "clock.h"
+#include "in_process_transport.h"
+#include "schunk_lcm_client.h"
+#include "wsg_simulator.h"
+
+DEFINE_int32(num_scenarios, 100, "Number of scenarios to run");
+DEFINE_int32(threads, 0,
+             "Number of worker threads; 0 uses one per hardware thread");
+DEFINE_double(duration_s, 10, "Simulated duration of each scenario");
+DEFINE_double(grasp_start_s, 1,
+              "Simulated time at which each scenario begins to grasp");
+DEFINE_double(grasp_force, 40, "Force (N) commanded for the grasp");
+DEFINE_bool(native_grasp, false,
+            "Use native Grasp/Release control instead of PrePosition "
+            "emulation");
+
+namespace schunk_driver {
+namespace {
+
+// Matches the period of the schunk_driver main loop.
+const int64_t kTickNs = 50000000;
+// Resolution of the simulation.
+const int64_t kStepNs = 1000000;
+// An arbitrary but realistic epoch for simulated time.
+const int64_t kStartNs = 1500000000L * 1000000000L;
+
+struct ScenarioResult {
+  int index {0};
+  double part_width_mm {0};
+  double final_width_mm {0};
+  double final_force {0};
+  int grasping_state {0};
+  uint64_t commands {0};  //< Gripper commands sent after calibration.
+  double wall_ms {0};
+};
+
+// Keeps the most recent status the client published.
+class StatusRecorder {
+ public:
+  void HandleStatus(const lcm::ReceiveBuffer*, const std::string&,
+                    const drake::lcmt_schunk_wsg_status* status) {
+    status_ = *status;
+  }
+
+  const drake::lcmt_schunk_wsg_status& status() const { return status_; }
+
+ private:
+  drake::lcmt_schunk_wsg_status status_{};
+};
+
+ScenarioResult RunScenario(int index) {
+  const auto wall_start = std::chrono::steady_clock::now();
+
+  // Spread the parts over most of the stroke.
+  const double part_width_mm = 20 + (index * 7) % 70;
+  WsgSimulatorParams params;
+  WsgSimulator simulator(params);
+  SimulatedClock clock(kStartNs, kStepNs);
+  clock.set_stepper([&simulator](int64_t now_ns) {
+      simulator.Step(now_ns);
+    });
+  // Each scenario has an LCM of its own, so that they cannot cross-talk.
+  lcm::LCM lcm("memq://");
+  const SchunkLcmClientParams client_params;
+  SchunkLcmClient client(
+      &lcm,
+      std::unique_ptr<WsgTransport>(
+          new InProcessTransport(&simulator, &clock)),
+      &clock, nullptr, client_params);
+  client.Initialize(nullptr);
+  const uint64_t calibration_commands = simulator.commands_received();
+  simulator.set_part_width_mm(part_width_mm);
+
+  StatusRecorder recorder;
+  lcm.subscribe(client_params.status_channel,
+                &StatusRecorder::HandleStatus, &recorder);
+
+  lcmt_schunk_wsg_mode_command command{};
+  command.control_mode = FLAGS_native_grasp
+      ? lcmt_schunk_wsg_mode_command::NATIVE_GRASP
+      : lcmt_schunk_wsg_mode_command::PREPOSITION_EMULATION;
+  const int64_t start_ns = clock.NowNs();
+  const int64_t grasp_ns = start_ns + FLAGS_grasp_start_s * 1e9;
+  const int64_t end_ns = start_ns + FLAGS_duration_s * 1e9;
+  while (clock.NowNs() < end_ns) {
+    command.utime = clock.NowUtime();
+    if (clock.NowNs() < grasp_ns) {
+      command.target_position_mm = params.stroke_mm;
+      command.force = 0;
+    } else {
+      command.target_position_mm = 0;
+      command.force = FLAGS_grasp_force;
+    }
+    lcm.publish(client_params.mode_command_channel, &command);
+    client.Task();
+    client.ProcessMessagesUntil(clock.NowNs() + kTickNs);
+  }
+  client.Task();
+  // Deliver the status published by that last Task().
+  while (lcm.handleTimeout(0) > 0) {}
+
+  ScenarioResult result;
+  result.index = index;
+  result.part_width_mm = part_width_mm;
+  result.final_width_mm = recorder.status().actual_position_mm;
+  // The driver signs force by the direction of motion.
+  result.final_force = std::fabs(recorder.status().actual_force);
+  result.grasping_state = simulator.grasping_state();
+  result.commands = simulator.commands_received() - calibration_commands;
+  result.wall_ms = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - wall_start).count();
+  return result;
+}
+
+int DoMain() {
+  const int num_threads = (FLAGS_threads > 0)
+      ? FLAGS_threads
+      : std::max(1u, std::thread::hardware_concurrency());
+  std::vector<ScenarioResult> results(FLAGS_num_scenarios);
+  std::atomic<int> next_index(0);
+
+  const auto wall_start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int i = 0; i < num_threads; i++) {
+    workers.emplace_back([&results, &next_index]() {
+        int index;
+        while ((index = next_index++) < FLAGS_num_scenarios) {
+          results[index] = RunScenario(index);
+        }
+      });
+  }
+  for (auto& worker : workers) { worker.join(); }
+  const double wall_s = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - wall_start).count();
+
+  printf("index,part_width_mm,final_width_mm,final_force,grasping_state,"
+         "commands,wall_ms\n");
+  for (const ScenarioResult& result : results) {
+    printf("%d,%.2f,%.2f,%.2f,%d,%llu,%.2f\n",
+           result.index, result.part_width_mm, result.final_width_mm,
+           result.final_force, result.grasping_state,
+           static_cast<unsigned long long>(result.commands), result.wall_ms);
+  }
+  fprintf(stderr, "Simulated %d x %.1fs scenarios on %d threads in %.3fs\n",
+          FLAGS_num_scenarios, FLAGS_duration_s, num_threads, wall_s);
+  return 0;
+}
+
+}  // namespace
+}  // namespace schunk_driver
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  return schunk_driver::DoMain();
+}
@@ -0,0 +1,99 @@
+#include "loop_probe.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "wsg_command_message.h"
+
+namespace schunk_driver {
+
+namespace {
+
+// Layout of the Loop payload: magic, sequence number, send time.
+const size_t kPayloadSize = sizeof(uint32_t) + sizeof(uint32_t) +
+                            sizeof(int64_t);
+
+}  // namespace
+
+LoopProbe::LoopProbe(Wsg* wsg, int64_t period_us, int64_t timeout_us)
+    : wsg_(wsg),
+      period_ns_(period_us * 1000),
+      timeout_ns_(timeout_us * 1000),
+      // Distinguishes our probes from those of any other process that might
+      // share the gripper link.
+      magic_(0x4c4f0000u | (static_cast<uint32_t>(getpid()) & 0xffffu)) {
+  rtt_us_.reserve(kMaxSamples);
+}
+
+bool LoopProbe::Poll(int64_t now_ns) {
+  for (int i = 0; i < kMaxOutstanding; i++) {
+    if (outstanding_send_ns_[i] != 0 &&
+        now_ns - outstanding_send_ns_[i] > timeout_ns_) {
+      outstanding_send_ns_[i] = 0;
+      counts_.lost++;
+    }
+  }
+  if (now_ns - last_send_ns_ < period_ns_) { return false; }
+
+  const uint32_t sequence = next_sequence_++;
+  int64_t& slot = outstanding_send_ns_[sequence % kMaxOutstanding];
+  if (slot != 0) { counts_.lost++; }
+  WsgCommandMessage command(kLoop, {});
+  command.AppendToPayload(magic_);
+  command.AppendToPayload(sequence);
+  command.AppendToPayload(now_ns);
+  wsg_->Send(command);
+  slot = now_ns;
+  last_send_ns_ = now_ns;
+  counts_.sent++;
+  return true;
+}
+
+bool LoopProbe::HandleResponse(const WsgReturnMessage& msg) {
+  if (msg.command() != kLoop) { return false; }
+  if (msg.status() != E_SUCCESS || msg.params().size() != kPayloadSize) {
+    return true;
+  }
+  uint32_t magic;
+  uint32_t sequence;
+  int64_t send_ns;
+  const unsigned char* data = msg.params().data();
+  memcpy(&magic, data, sizeof(magic));
+  memcpy(&sequence, data + 4, sizeof(sequence));
+  memcpy(&send_ns, data + 8, sizeof(send_ns));
+  if (magic != magic_) { return true; }
+
+  int64_t& slot = outstanding_send_ns_[sequence % kMaxOutstanding];
+  if (slot != send_ns) { return true; }  // Late, already counted lost.
+  slot = 0;
+  counts_.received++;
+
+  const double rtt_us = (msg.receive_time_ns() - send_ns) * 1e-3;
+  counts_.last_us = rtt_us;
+  if (min_rtt_us_ == 0 || rtt_us < min_rtt_us_) {
+    min_rtt_us_ = rtt_us;
+  }
+  if (static_cast<int>(rtt_us_.size()) < kMaxSamples) {
+    rtt_us_.push_back(rtt_us);
+  } else {
+    rtt_us_[next_rtt_] = rtt_us;
+    next_rtt_ = (next_rtt_ + 1) % kMaxSamples;
+  }
+  return true;
+}
+
+LoopProbe::Stats LoopProbe::GetStats() const {
+  Stats result = counts_;
+  if (rtt_us_.empty()) { return result; }
+  std::vector<double> sorted(rtt_us_);
+  std::sort(sorted.begin(), sorted.end());
+  const size_t last = sorted.size() - 1;
+  result.min_us = sorted.front();
+  result.p50_us = sorted[last / 2];
+  result.p99_us = sorted[(last * 99) / 100];
+  return result;
+}
+
+}  // namespace schunk_driver
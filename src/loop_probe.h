@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "wsg.h"
+#include "wsg_return_message.h"
+
+namespace schunk_driver {
+
+/// Measures the round trip time of the link to the gripper (network plus
+/// firmware) by periodically sending Loop commands, which the gripper echoes
+/// verbatim.  Each probe carries its sequence number and send time, and the
+/// echo is timed against its kernel receive stamp, so the measurement does
+/// not depend on how promptly the driver reads its socket.
+class LoopProbe {
+ public:
+  /// Round trip statistics over the most recent probes, in microseconds.
+  struct Stats {
+    uint64_t sent {0};
+    uint64_t received {0};
+    uint64_t lost {0};  //< Probes unanswered within the timeout.
+    double min_us {0};
+    double p50_us {0};
+    double p99_us {0};
+    double last_us {0};
+  };
+
+  /// Probes @p wsg (which must outlive this object) every @p period_us;
+  /// probes unanswered after @p timeout_us count as lost.
+  LoopProbe(Wsg* wsg, int64_t period_us, int64_t timeout_us);
+
+  /// Sends a probe if one is due, and expires unanswered probes.  Does not
+  /// block.  Returns true if a probe was sent.
+  bool Poll(int64_t now_ns);
+
+  /// Consumes @p msg if it is a Loop response, recording its round trip
+  /// time.  Returns true if @p msg was consumed.
+  bool HandleResponse(const WsgReturnMessage& msg);
+
+  /// Computes statistics over the retained round trip samples.  This sorts
+  /// a copy of the samples, so call it at a low rate.
+  Stats GetStats() const;
+
+  /// The fastest round trip seen so far in microseconds, or zero if no probe
+  /// has been answered.  Unlike GetStats(), this is constant time.
+  double min_rtt_us() const { return min_rtt_us_; }
+
+ private:
+  // Probes outstanding at once; older ones are counted lost when reused.
+  static const int kMaxOutstanding = 64;
+  // Round trip samples retained for percentile estimates.
+  static const int kMaxSamples = 1024;
+
+  Wsg* const wsg_;
+  const int64_t period_ns_;
+  const int64_t timeout_ns_;
+  const uint32_t magic_;
+
+  uint32_t next_sequence_ {0};
+  int64_t last_send_ns_ {0};
+  // Send time of each outstanding probe by sequence modulo kMaxOutstanding,
+  // or zero once answered or expired.
+  int64_t outstanding_send_ns_[kMaxOutstanding] {};
+
+  std::vector<double> rtt_us_;
+  int next_rtt_ {0};
+  double min_rtt_us_ {0};
+  Stats counts_;
+};
+
+}  // namespace schunk_driver
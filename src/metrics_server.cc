@@ -0,0 +1,93 @@
+#include "metrics_server.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace schunk_driver {
+
+MetricsServer::MetricsServer(in_port_t port, Writer writer)
+    : fd_(socket(AF_INET, SOCK_STREAM, 0)),
+      writer_(writer) {
+  if (fd_ < 0) {
+    throw std::runtime_error(std::string("socket failed: ") +
+                             strerror(errno));
+  }
+  int enable = 1;
+  setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  struct sockaddr_in local_sockaddr;
+  memset(&local_sockaddr, 0, sizeof(local_sockaddr));
+  local_sockaddr.sin_family = AF_INET;
+  local_sockaddr.sin_port = htons(port);
+  local_sockaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(fd_, (struct sockaddr *) &local_sockaddr,
+           sizeof(local_sockaddr)) != 0 ||
+      listen(fd_, 4) != 0) {
+    const std::string error = strerror(errno);
+    close(fd_);
+    throw std::runtime_error("Metrics port " + std::to_string(port) +
+                             " unavailable: " + error);
+  }
+  thread_ = std::thread(&MetricsServer::Run, this);
+}
+
+MetricsServer::~MetricsServer() {
+  running_ = false;
+  thread_.join();
+  close(fd_);
+}
+
+void MetricsServer::Run() {
+  while (running_) {
+    // Wake periodically to notice shutdown.
+    struct pollfd pfd = { fd_, POLLIN, 0 };
+    if (poll(&pfd, 1, 100) <= 0) { continue; }
+    const int client_fd = accept(fd_, nullptr, nullptr);
+    if (client_fd < 0) { continue; }
+    Serve(client_fd);
+    close(client_fd);
+  }
+}
+
+void MetricsServer::Serve(int client_fd) {
+  // Scrapers send a short GET; read (up to a limit) until its blank line,
+  // but answer regardless of what it asked for.
+  struct timeval timeout = { 1, 0 };
+  setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  std::string request;
+  char buffer[1024];
+  while (request.find("\r\n\r\n") == std::string::npos &&
+         request.size() < 8192) {
+    const ssize_t size = recv(client_fd, buffer, sizeof(buffer), 0);
+    if (size <= 0) { break; }
+    request.append(buffer, size);
+  }
+
+  std::ostringstream body;
+  writer_(body);
+  const std::string content = body.str();
+  std::ostringstream response;
+  response << "HTTP/1.0 200 OK\r\n"
+           << "Content-Type: application/openmetrics-text; version=1.0.0; "
+           << "charset=utf-8\r\n"
+           << "Content-Length: " << content.size() << "\r\n"
+           << "Connection: close\r\n\r\n"
+           << content;
+  const std::string data = response.str();
+  size_t sent = 0;
+  while (sent < data.size()) {
+    const ssize_t size = send(client_fd, data.data() + sent,
+                              data.size() - sent, MSG_NOSIGNAL);
+    if (size <= 0) { break; }
+    sent += size;
+  }
+}
+
+}  // namespace schunk_driver
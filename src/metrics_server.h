@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <ostream>
+#include <thread>
+
+#include <netinet/in.h>
+
+namespace schunk_driver {
+
+/// Serves OpenMetrics text over HTTP on 127.0.0.1, from its own thread, so
+/// that scrapes never run on (or block) the control loop.  Every request,
+/// whatever its path, receives the current metrics.
+class MetricsServer {
+ public:
+  /// Writes the body of a response.  Called on the server thread, so it must
+  /// only read state that is safe to read concurrently (eg WsgMetrics).
+  typedef std::function<void(std::ostream&)> Writer;
+
+  /// Listens on @p port; throws std::runtime_error if that fails.
+  MetricsServer(in_port_t port, Writer writer);
+
+  /// Stops serving.
+  ~MetricsServer();
+
+ private:
+  void Run();
+  void Serve(int client_fd);
+
+  const int fd_;
+  const Writer writer_;
+  std::atomic<bool> running_ {true};
+  std::thread thread_;
+};
+
+}  // namespace schunk_driver
@@ -0,0 +1,53 @@
+#include "motion_prediction.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace schunk_driver {
+
+namespace {
+
+// Integration step.  A profile is piecewise constant acceleration, so this
+// only needs to be short against its phases; predictions span a few tens of
+// milliseconds, so the cost is a few dozen steps.
+const double kStepS = 0.001;
+
+}  // namespace
+
+FingerMotion PredictFingerMotion(const FingerMotion& start, double target_mm,
+                                 double duration_s,
+                                 double max_speed_mm_per_s,
+                                 double max_acc_mm_per_ss) {
+  FingerMotion motion = start;
+  if (max_acc_mm_per_ss <= 0 || max_speed_mm_per_s <= 0) { return motion; }
+  for (double t = 0; t < duration_s; t += kStepS) {
+    const double dt = std::min(kStepS, duration_s - t);
+    const double to_go_mm = target_mm - motion.position_mm;
+    const double v = motion.speed_mm_per_s;
+    // Stop on the target once it is within a step's worth of deceleration.
+    if (std::abs(to_go_mm) <= std::abs(v) * dt &&
+        std::abs(v) <= max_acc_mm_per_ss * dt) {
+      motion.position_mm = target_mm;
+      motion.speed_mm_per_s = 0;
+      break;
+    }
+    // Brake if moving away from the target or if stopping from this speed
+    // takes all the distance left; otherwise speed up toward it.
+    const double direction = (to_go_mm > 0) ? 1 : -1;
+    const double stopping_mm = v * v / (2 * max_acc_mm_per_ss);
+    double acc = direction * max_acc_mm_per_ss;
+    if (v * direction > 0 && stopping_mm >= std::abs(to_go_mm)) {
+      acc = -acc;
+    } else if (v * direction >= max_speed_mm_per_s) {
+      acc = 0;
+    }
+    double next_v = v + acc * dt;
+    next_v = std::max(-max_speed_mm_per_s,
+                      std::min(max_speed_mm_per_s, next_v));
+    motion.position_mm += 0.5 * (v + next_v) * dt;
+    motion.speed_mm_per_s = next_v;
+  }
+  return motion;
+}
+
+}  // namespace schunk_driver
@@ -0,0 +1,23 @@
+#pragma once
+
+namespace schunk_driver {
+
+/// Position and signed speed of the fingers; positive speed opens them.
+struct FingerMotion {
+  double position_mm {0};
+  double speed_mm_per_s {0};
+};
+
+/// Predicts where the fingers will be @p duration_s after they were
+/// observed at @p start, assuming they are driving to @p target_mm as the
+/// firmware's motion profile does: accelerating at @p max_acc_mm_per_ss up
+/// to @p max_speed_mm_per_s, then decelerating to stop on the target.
+///
+/// Contact is not modeled, so the prediction is only as good as the
+/// assumption that the fingers are moving freely.
+FingerMotion PredictFingerMotion(const FingerMotion& start, double target_mm,
+                                 double duration_s,
+                                 double max_speed_mm_per_s,
+                                 double max_acc_mm_per_ss);
+
+}  // namespace schunk_driver
@@ -1,8 +1,14 @@
 #include "position_force_control.h"
 
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <cstring>
+#include <iostream>
+#include <stdexcept>
 
+#include "motion_prediction.h"
+#include "trace.h"
 #include "wsg.h"
 #include "wsg_command_message.h"
 #include "wsg_command_sender.h"
@@ -12,49 +18,187 @@
 
 namespace schunk_driver {
 
-const static uint16_t kUpdatePeriodMs = 20;
 const static double kUpdateAdjustTimeout = 0.25;
 
-const static double kForceDeadband = 5;
-const static double kPositionDeadbandMm = 5;
+// Enough for several seconds of every periodic status stream.
+const static int kStatusHistoryCapacity = 4096;
 
-PositionForceControl::PositionForceControl(std::unique_ptr<Wsg> wsg)
-    : wsg_(std::move(wsg)) {}
+// Below this speed the fingers are taken to be stopped (on the target, or
+// blocked), and their position is not extrapolated.
+const static double kMovingSpeedMmPerS = 1;
+
+// Positions older than this are stale enough that the status stream has
+// probably stalled; extrapolating further would only compound the error.
+const static double kMaxPredictionS = 0.25;
+
+// No message is handled later than this after its receipt; an older
+// receive stamp means the wall clock stepped in between.
+const static int64_t kMaxMessageAgeNs = 1000000000;
+
+// The periodic status streams enabled by DoCalibrationSteps().
+const static Command kStatusStreams[] = {
+  kGetSystemState, kGetGraspState, kGetOpeningWidth, kGetSpeed, kGetForce};
+
+PositionForceControl::PositionForceControl(std::unique_ptr<Wsg> wsg,
+                                           const ControlParams& params)
+    : wsg_(std::move(wsg)),
+      params_(params),
+      history_(kStatusHistoryCapacity),
+      stream_models_(std::end(kStatusStreams) - std::begin(kStatusStreams),
+                     ArrivalTimeModel(params.status_period_ms * 1000000L)) {}
+
+
+void PositionForceControl::EnableFingerData(
+    int64_t poll_period_us, int max_batch_samples) {
+  fingers_.reset(new FingerData(wsg_.get(), poll_period_us,
+                                max_batch_samples));
+}
+
+
+void PositionForceControl::EnableLoopProbe(
+    int64_t period_us, int64_t timeout_us) {
+  loop_probe_.reset(new LoopProbe(wsg_.get(), period_us, timeout_us));
+}
+
+
+void PositionForceControl::EnableGraspProfiling(
+    const GraspProfilerParams& params, GraspProfiler::Listener listener) {
+  grasp_profiler_.reset(new GraspProfiler(wsg_.get(), params,
+                                          std::move(listener)));
+}
+
+
+void PositionForceControl::EnableMetrics(
+    WsgMetrics* metrics, int64_t temperature_period_us) {
+  metrics_ = metrics;
+  temperature_period_us_ = temperature_period_us;
+  wsg_->set_metrics(metrics);
+}
+
+
+void PositionForceControl::EnableWaitPolicy(const WaitPolicyParams& params) {
+  if (wsg_->receive_fd() < 0) {
+    throw std::runtime_error("Transport cannot be waited upon");
+  }
+  wait_policy_.reset(new WaitPolicy(wsg_->receive_fd(), params));
+  wsg_->set_wait_policy(wait_policy_.get());
+  wsg_->set_response_latency_ns(params.response_latency_ns);
+}
+
+
+bool PositionForceControl::WaitForMessage(int64_t deadline_ns) {
+  if (wait_policy_) {
+    return wait_policy_->WaitUntil(deadline_ns);
+  }
+  wsg_->clock()->SleepForNs(deadline_ns - wsg_->clock()->NowNs());
+  return false;
+}
 
 
 void PositionForceControl::DoCalibrationSteps() {
+  TraceSpan calibration("calibration", "DoCalibrationSteps");
+
   // Print the system info for the user and fail fast if contacting the
   // gripper fails.  Result not currently used otherwise.
-  wsg_->GetSystemInfo();
+  {
+    TraceSpan span("calibration", "GetSystemInfo");
+    wsg_->GetSystemInfo();
+  }
+
+  if (fingers_) {
+    TraceSpan span("calibration", "InitializeFingers");
+    fingers_->Initialize();
+  }
 
   // Set up periodic status updates on every available state structure.
   // We don't use all of these but we have bandwidth to spare and this
   // ensures we'll have them available in pcap debugging.
-  wsg_->TurnOnUpdates(kGetSystemState, kUpdatePeriodMs, kUpdateAdjustTimeout);
-  wsg_->TurnOnUpdates(kGetGraspState, kUpdatePeriodMs, kUpdateAdjustTimeout);
-  wsg_->TurnOnUpdates(kGetOpeningWidth, kUpdatePeriodMs, kUpdateAdjustTimeout);
-  wsg_->TurnOnUpdates(kGetSpeed, kUpdatePeriodMs, kUpdateAdjustTimeout);
-  wsg_->TurnOnUpdates(kGetForce, kUpdatePeriodMs, kUpdateAdjustTimeout);
+  for (Command command : kStatusStreams) {
+    TraceSpan span("calibration", "TurnOnUpdates");
+    span.SetArg(0, "command", command);
+    wsg_->TurnOnUpdates(command, params_.status_period_ms,
+                        kUpdateAdjustTimeout);
+  }
 
   // Home the fingers (to calibrate extents) and tare the sensors.
-  wsg_->Home(Wsg::kNegative);
-  wsg_->Home(Wsg::kPositive);
-  wsg_->Tare();
+  {
+    TraceSpan span("calibration", "HomeNegative");
+    wsg_->Home(Wsg::kNegative);
+  }
+  {
+    TraceSpan span("calibration", "HomePositive");
+    wsg_->Home(Wsg::kPositive);
+  }
+  {
+    TraceSpan span("calibration", "Tare");
+    wsg_->Tare();
+  }
 
   // Get physical limits.
-  physical_limits_ = wsg_->GetPhysicalLimits();
+  {
+    TraceSpan span("calibration", "GetPhysicalLimits");
+    physical_limits_ = wsg_->GetPhysicalLimits();
+  }
 
   // Set all limits to their maxima.
+  TraceSpan span("calibration", "SetLimits");
   wsg_->ClearSoftLimits();
   wsg_->SetAcceleration(physical_limits_.max_acc_mm_per_ss_);
 }
 
 
+ControllerState PositionForceControl::GetState() const {
+  ControllerState state;
+  state.physical_limits = physical_limits_;
+  state.system_state = system_state_;
+  state.grasping_state = grasping_state_;
+  state.position_mm = last_position_mm_;
+  state.force = last_applied_force_;
+  state.speed_mm_per_s = last_speed_mm_per_s_;
+  state.executing_target_position_mm = executing_target_position_mm_;
+  state.executing_force = executing_force_;
+  state.executing_speed_mm_per_s = executing_speed_mm_per_s_;
+  state.control_mode = control_mode_;
+  state.native_command = native_command_;
+  state.grasp_after_release = grasp_after_release_;
+  return state;
+}
+
+
+void PositionForceControl::RestoreState(const ControllerState& state) {
+  if (fingers_) {
+    fingers_->Initialize();
+  }
+  for (Command command : kStatusStreams) {
+    wsg_->TurnOnUpdates(command, params_.status_period_ms,
+                        kUpdateAdjustTimeout);
+  }
+
+  physical_limits_ = state.physical_limits;
+  system_state_ = state.system_state;
+  grasping_state_ = state.grasping_state;
+  last_position_mm_ = state.position_mm;
+  last_applied_force_ = state.force;
+  last_speed_mm_per_s_ = state.speed_mm_per_s;
+  executing_target_position_mm_ = state.executing_target_position_mm;
+  executing_force_ = state.executing_force;
+  executing_speed_mm_per_s_ = state.executing_speed_mm_per_s;
+  control_mode_ = static_cast<ControlMode>(state.control_mode);
+  native_command_ = state.native_command;
+  grasp_after_release_ = state.grasp_after_release;
+}
+
+
 void PositionForceControl::SetPositionAndForce(
     double commanded_position_mm, double commanded_force) {
-  // Use the preposition command (which is SPECIFICALLY NOT INTENDED for this
-  // use case) to emulate force control.
+  SetPositionAndForce(commanded_position_mm, commanded_force,
+                      kPrepositionEmulation, 0);
+}
+
 
+void PositionForceControl::SetPositionAndForce(
+    double commanded_position_mm, double commanded_force,
+    ControlMode mode, double speed_mm_per_s) {
   commanded_position_mm = std::min(
       commanded_position_mm,
       static_cast<double>(physical_limits_.stroke_mm_));
@@ -62,32 +206,122 @@ void PositionForceControl::SetPositionAndForce(
       commanded_force,
       static_cast<double>(physical_limits_.overdrive_force_));
 
+  if (wsg_->staging()) {
+    // The episode starts once ReleaseStagedCommand() sends the command.
+    staged_position_mm_ = commanded_position_mm;
+    staged_force_ = commanded_force;
+    staged_mode_ = mode;
+  } else if (grasp_profiler_) {
+    grasp_profiler_->SetTarget(wsg_->clock()->NowUtime(),
+                               commanded_position_mm, commanded_force, mode);
+  }
+
+  if (mode != control_mode_) {
+    // Whatever the other mode left executing says nothing about this one.
+    native_command_ = 0;
+    grasp_after_release_ = false;
+    control_mode_ = mode;
+  }
+
+  switch (mode) {
+    case kPrepositionEmulation: {
+      CommandPrepositionEmulation(commanded_position_mm, commanded_force);
+      break;
+    }
+    case kNativeGrasp: {
+      if (speed_mm_per_s <= 0 ||
+          speed_mm_per_s > physical_limits_.max_speed_mm_per_s_) {
+        speed_mm_per_s = physical_limits_.max_speed_mm_per_s_;
+      }
+      CommandNativeGrasp(commanded_position_mm, commanded_force,
+                         speed_mm_per_s);
+      break;
+    }
+  }
+}
+
+
+void PositionForceControl::SetForceLimit(double commanded_force) {
+  assert(!wsg_->has_staged());
+  commanded_force = std::min(commanded_force, max_force());
+  wsg_->SetForceLimitNonblocking(commanded_force);
+  executing_force_ = commanded_force;
+}
+
+
+void PositionForceControl::StageCommand(
+    double commanded_position_mm, double commanded_force,
+    ControlMode mode, double speed_mm_per_s) {
+  if (wsg_->has_staged()) {
+    wsg_->DiscardStaged();
+  } else {
+    unstaged_state_ = GetState();
+  }
+  native_command_ = 0;
+  recommand_unconditionally_ = true;
+  wsg_->set_staging(true);
+  SetPositionAndForce(commanded_position_mm, commanded_force,
+                      mode, speed_mm_per_s);
+  wsg_->set_staging(false);
+  recommand_unconditionally_ = false;
+}
+
+
+void PositionForceControl::ReleaseStagedCommand() {
+  if (!wsg_->has_staged()) { return; }
+  if (grasp_profiler_) {
+    // Before sending, so that the episode counts the staged commands.
+    grasp_profiler_->SetTarget(wsg_->clock()->NowUtime(), staged_position_mm_,
+                               staged_force_, staged_mode_);
+  }
+  wsg_->SendStaged();
+}
+
+
+void PositionForceControl::DiscardStagedCommand() {
+  if (!wsg_->has_staged()) { return; }
+  wsg_->DiscardStaged();
+  executing_target_position_mm_ = unstaged_state_.executing_target_position_mm;
+  executing_force_ = unstaged_state_.executing_force;
+  executing_speed_mm_per_s_ = unstaged_state_.executing_speed_mm_per_s;
+  control_mode_ = static_cast<ControlMode>(unstaged_state_.control_mode);
+  native_command_ = unstaged_state_.native_command;
+  grasp_after_release_ = unstaged_state_.grasp_after_release;
+}
+
+
+void PositionForceControl::CommandPrepositionEmulation(
+    double commanded_position_mm, double commanded_force) {
+  // Use the preposition command (which is SPECIFICALLY NOT INTENDED for this
+  // use case) to emulate force control.
+
   bool must_recommand = false;
 
   // If the commanded force is outside of our force deadband, we must
   // recommand.
-  if (fabs(commanded_force - force()) > kForceDeadband) {
+  if (fabs(commanded_force - force()) > params_.force_deadband ||
+      recommand_unconditionally_) {
     must_recommand = true;
   }
 
   // If the commanded position and executing position are in opposite
   // directions from the current position we must recommand.
-  if (commanded_position_mm > position_mm() &&
-      position_mm() > executing_target_position_mm_) {
+  const double position_mm = DecisionPositionMm();
+  if (commanded_position_mm > position_mm &&
+      position_mm > executing_target_position_mm_) {
     must_recommand = true;
-  } else if (commanded_position_mm < position_mm() &&
-             position_mm() < executing_target_position_mm_) {
+  } else if (commanded_position_mm < position_mm &&
+             position_mm < executing_target_position_mm_) {
     must_recommand = true;
   }
 
 
+  if (metrics_) { metrics_->CountRecommand(must_recommand); }
   if (!must_recommand) { return; }
 
   wsg_->SetForceLimitNonblocking(commanded_force);
   executing_force_ = commanded_force;
 
-  // TODO(ggould-tri) consider using grip command when motion is inward; this
-  // is more correct but probably requires handling many more result statuses.
   wsg_->PrepositionNonblocking(
       Wsg::kPrepositionClampOnBlock, Wsg::kPrepositionAbsolute,
       commanded_position_mm, physical_limits_.max_speed_mm_per_s_);
@@ -95,16 +329,166 @@ void PositionForceControl::SetPositionAndForce(
 }
 
 
+void PositionForceControl::CommandNativeGrasp(
+    double commanded_position_mm, double commanded_force,
+    double speed_mm_per_s) {
+  // Unlike the emulation, compare against what we last commanded rather than
+  // what we measure: the firmware regulates force itself once holding.
+  const bool target_changed =
+      native_command_ == 0 ||
+      fabs(commanded_position_mm - executing_target_position_mm_) >
+      params_.position_deadband_mm;
+  const bool force_changed =
+      fabs(commanded_force - executing_force_) > params_.force_deadband;
+
+  if (metrics_) { metrics_->CountRecommand(target_changed || force_changed); }
+  if (!target_changed) {
+    if (force_changed) {
+      // The force limit applies to a grasp already in progress.
+      wsg_->SetForceLimitNonblocking(commanded_force);
+      executing_force_ = commanded_force;
+    }
+    return;
+  }
+
+  executing_target_position_mm_ = commanded_position_mm;
+  executing_force_ = commanded_force;
+  executing_speed_mm_per_s_ = speed_mm_per_s;
+  grasp_after_release_ = false;
+
+  const double position_mm = DecisionPositionMm();
+  if (commanded_position_mm < position_mm) {
+    if (grasping_state_ == kHolding || grasping_state_ == kGrasping) {
+      // The firmware will not start a new grasp while one is active, so
+      // release a little first and grasp when the release completes.
+      const static double kRegraspPullBackMm = 1;
+      wsg_->ReleaseNonblocking(kRegraspPullBackMm, speed_mm_per_s);
+      native_command_ = kRelease;
+      grasp_after_release_ = true;
+    } else {
+      SendNativeGrasp();
+    }
+  } else if (grasping_state_ == kHolding) {
+    wsg_->ReleaseNonblocking(commanded_position_mm - position_mm,
+                             speed_mm_per_s);
+    native_command_ = kRelease;
+  } else {
+    wsg_->PrepositionNonblocking(
+        Wsg::kPrepositionStopOnBlock, Wsg::kPrepositionAbsolute,
+        commanded_position_mm, speed_mm_per_s);
+    native_command_ = kPrePosition;
+  }
+}
+
+
+void PositionForceControl::SendNativeGrasp() {
+  wsg_->SetForceLimitNonblocking(executing_force_);
+  wsg_->GraspNonblocking(executing_target_position_mm_,
+                         executing_speed_mm_per_s_);
+  native_command_ = kGrasp;
+}
+
+
+void PositionForceControl::HandleMotionResponse(const WsgReturnMessage& msg) {
+  if (control_mode_ != kNativeGrasp || msg.command() != native_command_) {
+    return;  // Not the motion we are tracking.
+  }
+  if (wsg_->has_staged()) {
+    // native_command_ is already the staged motion, which will supersede
+    // whatever this response is about.
+    return;
+  }
+  if (msg.status() == E_CMD_PENDING) { return; }
+  switch (msg.status()) {
+    case E_SUCCESS: {
+      if (native_command_ == kRelease && grasp_after_release_) {
+        grasp_after_release_ = false;
+        SendNativeGrasp();
+      }
+      break;
+    }
+    case E_CMD_ABORTED: {
+      break;  // Superseded by a newer command of our own.
+    }
+    case E_ALREADY_RUNNING: {
+      // Some other motion is in progress; stop it and recommand the target
+      // on the next call to SetPositionAndForce().
+      wsg_->Stop();
+      native_command_ = 0;
+      break;
+    }
+    case E_ACCESS_DENIED: {
+      std::cerr << "Motion command " << msg.command() << " denied"
+                << ((system_state_ & SF_FAST_STOP)
+                    ? " (fast stop must be acknowledged)" : "")
+                << std::endl;
+      break;
+    }
+    default: {
+      // E_CMD_FAILED (eg no part found), E_AXIS_BLOCKED, E_RANGE_ERROR etc.
+      // The grasping state reports the consequences; retrying the same
+      // target would only repeat the failure, so wait for a new one.
+      std::cerr << "Motion command " << msg.command() << " failed with status "
+                << msg.status() << std::endl;
+      break;
+    }
+  }
+}
+
+
+void PositionForceControl::AddStatusListener(StatusListener listener) {
+  status_listeners_.push_back(std::move(listener));
+}
+
+
 void PositionForceControl::Task() {
+  if (loop_probe_) {
+    loop_probe_->Poll(wsg_->clock()->NowNs());
+  }
+  if (metrics_) {
+    metrics_->SetSocketDrops(wsg_->receive_drops());
+    if (wait_policy_) {
+      metrics_->SetWaitTimes(wait_policy_->stats().spin_ns,
+                             wait_policy_->stats().block_ns);
+    }
+    const int64_t now_us = wsg_->clock()->NowUtime();
+    if (now_us - last_temperature_poll_us_ >= temperature_period_us_) {
+      // Without parameters, a one-shot read.
+      wsg_->Send(WsgCommandMessage(kGetTemperature, {}));
+      last_temperature_poll_us_ = now_us;
+    }
+  }
   std::unique_ptr<WsgReturnMessage> msg;
   do {
-    msg = wsg_->rx().Receive();
-    if (!msg || msg->status() != E_SUCCESS) {
+    msg = wsg_->Receive();
+    if (!msg) { continue; }
+    if (fingers_ &&
+        fingers_->HandleResponse(*msg, msg->receive_time_ns() / 1000)) {
+      continue;
+    }
+    if (loop_probe_ && loop_probe_->HandleResponse(*msg)) {
+      // The fastest round trip is the earliest a response can arrive.
+      if (loop_probe_->min_rtt_us() > 0) {
+        wsg_->set_response_latency_ns(
+            static_cast<int64_t>(loop_probe_->min_rtt_us() * 1000));
+      }
+      continue;
+    }
+    if (grasp_profiler_ && grasp_profiler_->HandleResponse(*msg)) {
+      continue;
+    }
+    if (msg->command() == kGrasp || msg->command() == kRelease ||
+        msg->command() == kPrePosition) {
+      HandleMotionResponse(*msg);
+      continue;
+    }
+    if (msg->status() != E_SUCCESS) {
       continue;  // TODO(ggould-tri) any error handling at all.
     }
     switch (msg->command()) {
       case kGetSystemState: {
         memcpy(&system_state_, msg->params().data(), sizeof(system_state_));
+        if (metrics_) { metrics_->SetSystemState(system_state_); }
         break;
       }
       case kGetGraspState: {
@@ -130,9 +514,110 @@ void PositionForceControl::Task() {
         last_speed_mm_per_s_ = speed_float;
         break;
       }
-      default: break;  // Discard uninteresting messages.
+      case kGetTemperature: {
+        // Reported in tenths of a degree Celsius.
+        int16_t temperature;
+        memcpy(&temperature, msg->params().data(), sizeof(temperature));
+        if (metrics_) { metrics_->SetTemperature(temperature / 10.0); }
+        continue;  // Not a status sample.
+      }
+      default: continue;  // Discard uninteresting messages.
     }
+    RecordStatusSample(*msg);
   } while (msg);
+  // Only now that any response has been handled may the next request go,
+  // or a request be deemed to have timed out.
+  if (fingers_) {
+    fingers_->Poll(wsg_->clock()->NowUtime());
+  }
+  if (grasp_profiler_) {
+    grasp_profiler_->Poll(wsg_->clock()->NowUtime());
+  }
+}
+
+
+ArrivalTimeModel* PositionForceControl::StatusStreamModel(int command) {
+  for (size_t i = 0; i < stream_models_.size(); i++) {
+    if (kStatusStreams[i] == command) { return &stream_models_[i]; }
+  }
+  return nullptr;
+}
+
+
+void PositionForceControl::RecordStatusSample(const WsgReturnMessage& msg) {
+  StatusSample sample;
+  sample.receive_utime = msg.receive_time_ns() / 1000;
+  sample.acquisition_utime = sample.receive_utime;
+  // Receive times are stamped on the wall clock; carry them over to the
+  // monotonic clock by their age, which is bounded in case the wall clock
+  // stepped since.
+  Clock* const clock = wsg_->clock();
+  const int64_t age_ns = std::min(
+      std::max<int64_t>(0, clock->NowNs() - msg.receive_time_ns()),
+      kMaxMessageAgeNs);
+  sample.monotonic_utime = (clock->MonotonicNs() - age_ns) / 1000;
+  ArrivalTimeModel* model = StatusStreamModel(msg.command());
+  if (model) {
+    int64_t acquisition_ns = model->Update(msg.receive_time_ns());
+    if (wait_policy_ && model->locked()) {
+      wait_policy_->ExpectPeriodic(model - stream_models_.data(),
+                                   model->next_arrival_ns(),
+                                   model->period_ns());
+    }
+    // The gripper's clock is not visible to us, so offset the host arrival
+    // time by the one-way latency, taken as half the fastest round trip.
+    if (loop_probe_) {
+      acquisition_ns -= static_cast<int64_t>(loop_probe_->min_rtt_us() * 500);
+    }
+    sample.acquisition_utime = acquisition_ns / 1000;
+  }
+  if (msg.command() == kGetOpeningWidth) {
+    position_acquisition_ns_ = sample.acquisition_utime * 1000;
+  }
+  sample.command = msg.command();
+  sample.position_mm = last_position_mm_;
+  sample.speed_mm_per_s = last_speed_mm_per_s_;
+  sample.force = last_applied_force_;
+  sample.system_state = system_state_;
+  sample.grasping_state = grasping_state_;
+  history_.Record(sample);
+  if (grasp_profiler_) {
+    grasp_profiler_->HandleStatus(sample.acquisition_utime, sample.position_mm,
+                                  sample.speed_mm_per_s, sample.force,
+                                  sample.grasping_state);
+  }
+  for (const auto& listener : status_listeners_) {
+    listener(sample);
+  }
+}
+
+
+double PositionForceControl::DecisionPositionMm() const {
+  if (!params_.predict_motion || position_acquisition_ns_ == 0 ||
+      grasping_state_ == kHolding ||
+      std::abs(last_speed_mm_per_s_) < kMovingSpeedMmPerS) {
+    return last_position_mm_;
+  }
+  // The measurement is already as old as its age, and a command sent now
+  // takes effect a one-way link delay later still.
+  int64_t lead_ns = wsg_->clock()->NowNs() - position_acquisition_ns_;
+  if (loop_probe_) {
+    lead_ns += static_cast<int64_t>(loop_probe_->min_rtt_us() * 500);
+  }
+  if (lead_ns <= 0) { return last_position_mm_; }
+  FingerMotion start;
+  start.position_mm = last_position_mm_;
+  start.speed_mm_per_s = last_speed_mm_per_s_;
+  // The motion in progress is toward the executing target, at the speed it
+  // was commanded with (PrePosition emulation always uses the maximum) and
+  // the maximum acceleration set by DoCalibrationSteps().
+  const double speed_mm_per_s =
+      (control_mode_ == kNativeGrasp && executing_speed_mm_per_s_ > 0)
+      ? executing_speed_mm_per_s_ : physical_limits_.max_speed_mm_per_s_;
+  return PredictFingerMotion(
+      start, executing_target_position_mm_,
+      std::min(lead_ns * 1e-9, kMaxPredictionS),
+      speed_mm_per_s, physical_limits_.max_acc_mm_per_ss_).position_mm;
 }
 
 
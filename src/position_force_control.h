@@ -1,10 +1,77 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "arrival_time_model.h"
+#include "finger_data.h"
+#include "grasp_profiler.h"
+#include "loop_probe.h"
+#include "status_history.h"
+#include "wait_policy.h"
 #include "wsg.h"
+#include "wsg_metrics.h"
 #include "wsg_return_message.h"
 
 namespace schunk_driver {
 
+/// The state of the gripper as of the receipt of a single periodic status
+/// message.  Each status message updates only one quantity; the others are
+/// carried over from the most recent message that reported them.
+struct StatusSample {
+  int64_t receive_utime {0};  //< Host wall-clock time of arrival.
+  /// Time of arrival on the host's monotonic clock (Clock::MonotonicNs()),
+  /// which orders samples even across steps of the wall clock.
+  int64_t monotonic_utime {0};
+  /// Estimated host wall-clock time at which the gripper took the sample:
+  /// the arrival time with network and scheduling jitter removed, less the
+  /// one-way link latency if it is being measured.
+  int64_t acquisition_utime {0};
+  int command {0};  //< The status command (eg kGetForce) that triggered this.
+  double position_mm {0};
+  double speed_mm_per_s {0};
+  double force {0};
+  uint32_t system_state {0};  //< Bit-union of StateFlag values.
+  GraspingState grasping_state {kIdle};
+};
+
+/// Tuning parameters of PositionForceControl.  The defaults are the values
+/// the driver has always used; see autotune for choosing others.
+struct ControlParams {
+  /// Difference (N) between target and measured force (or, for
+  /// kNativeGrasp, executing force) beyond which the gripper is recommanded.
+  double force_deadband {5};
+  /// In kNativeGrasp mode, change of target (mm) beyond which the gripper
+  /// is recommanded.
+  double position_deadband_mm {5};
+  /// Period (ms) of each of the gripper's periodic status streams.
+  int status_period_ms {20};
+  /// Whether to make recommand decisions against the finger position
+  /// predicted for when a command would take effect, rather than the last
+  /// one reported.  The reported position is at least a status period plus
+  /// the link delay old, which matters when the fingers move fast.
+  bool predict_motion {false};
+};
+
+/// Everything PositionForceControl knows about the gripper and what it has
+/// commanded, as needed to resume control without recalibrating.  Plain
+/// data, so that it may be copied through shared memory.
+struct ControllerState {
+  PhysicalLimits physical_limits;
+  uint32_t system_state {0};
+  GraspingState grasping_state {kIdle};
+  double position_mm {0};
+  double force {0};
+  double speed_mm_per_s {0};
+  double executing_target_position_mm {0};
+  double executing_force {0};
+  double executing_speed_mm_per_s {0};
+  int control_mode {0};
+  int native_command {0};
+  bool grasp_after_release {false};
+};
+
 /// Class that emulates position/force control of the Schunk gripper ("WSG").
 /// Takes target position and force in and attempts to reach that position
 /// with that force.  Emits the achieved position and applied force.
@@ -13,7 +80,51 @@ class PositionForceControl {
   /// Start position/force control on the given WSG device.  Takes ownership
   /// of @p wsg because nobody else should be poking at the device while this
   /// controller is operating.
-  PositionForceControl(std::unique_ptr<Wsg> wsg);
+  PositionForceControl(std::unique_ptr<Wsg> wsg,
+                       const ControlParams& params = ControlParams());
+
+  /// Enables polling of smart finger data every @p poll_period_us, batching
+  /// up to @p max_batch_samples samples between calls to fingers()->Clear().
+  /// Must be called before DoCalibrationSteps(), which discovers and powers
+  /// the fingers.
+  void EnableFingerData(int64_t poll_period_us, int max_batch_samples);
+
+  /// The finger data subsystem, or nullptr if EnableFingerData() has not
+  /// been called.
+  FingerData* fingers() { return fingers_.get(); }
+
+  /// Enables link round trip probing with Loop commands every
+  /// @p period_us, counting probes unanswered after @p timeout_us as lost.
+  void EnableLoopProbe(int64_t period_us, int64_t timeout_us);
+
+  /// The link probe, or nullptr if EnableLoopProbe() has not been called.
+  const LoopProbe* loop_probe() const { return loop_probe_.get(); }
+
+  /// Records traffic, errors, recommand decisions, state flags, socket drops
+  /// and (polled every @p temperature_period_us) temperature into
+  /// @p metrics, which must outlive this object.
+  void EnableMetrics(WsgMetrics* metrics, int64_t temperature_period_us);
+
+  /// Profiles each episode of control, from a new target until the fingers
+  /// settle or the next new target, calling @p listener from within Task()
+  /// with its summary once the firmware's grasp statistics are in.
+  void EnableGraspProfiling(const GraspProfilerParams& params,
+                            GraspProfiler::Listener listener);
+
+  /// Waits for messages from the gripper with a WaitPolicy, spinning around
+  /// the expected arrival of each periodic status message and blocking
+  /// otherwise, rather than spinning throughout SendAndAwaitResponse().
+  /// Requires a transport with a receive descriptor and a SystemClock;
+  /// throws std::runtime_error if the transport has none.
+  void EnableWaitPolicy(const WaitPolicyParams& params);
+
+  /// The wait policy, or nullptr if EnableWaitPolicy() has not been called.
+  const WaitPolicy* wait_policy() const { return wait_policy_.get(); }
+
+  /// Waits until a message from the gripper may be pending or until
+  /// @p deadline_ns, returning true in the first case.  Without a wait
+  /// policy this simply sleeps until the deadline.
+  bool WaitForMessage(int64_t deadline_ns);
 
   /// Performs initial configuration and calibration of the WSG.  This moves
   /// the gripper fingers, so don't do it while the fingers are grasping or
@@ -28,10 +139,65 @@ class PositionForceControl {
   /// with the default hard fingers) and zero target force.
   void DoCalibrationSteps();
 
+  /// Returns the state needed to resume control in another process.
+  ControllerState GetState() const;
+
+  /// Resumes control of a gripper already calibrated and commanded by
+  /// another controller whose GetState() returned @p state.  Unlike
+  /// DoCalibrationSteps() this does not move the fingers; it only
+  /// (re-)enables the status streams and any smart fingers.
+  void RestoreState(const ControllerState& state);
+
+  /// How target position and force are realized on the gripper.
+  enum ControlMode {
+    /// Emulate force control with PrePosition commands, recommanding whenever
+    /// the measured force leaves a deadband around the target.
+    kPrepositionEmulation = 0,
+    /// Use the firmware's Grasp/Release commands: inward targets grasp a part
+    /// of the target width at the target force, outward targets release.
+    /// Commands are resent only when the target itself changes.
+    kNativeGrasp = 1,
+  };
+
   /// Sets the target position (in millimeters of base separation) and force
-  /// (in Newtons, positive-outward).
+  /// (in Newtons, positive-outward), using kPrepositionEmulation.
   void SetPositionAndForce(double position_mm, double force);
 
+  /// Sets the target position and force as above, using @p mode.  Motions
+  /// run at @p speed_mm_per_s, or at the maximum speed if it is not positive.
+  void SetPositionAndForce(double position_mm, double force,
+                           ControlMode mode, double speed_mm_per_s);
+
+  /// Changes the force limit of the command being executed to @p force
+  /// without changing its target, regardless of force_deadband; eg to grip
+  /// harder by less than the deadband when a part slips.  Later calls to
+  /// SetPositionAndForce() must pass the same force to keep it.  Like
+  /// SetPositionAndForce(), clamps @p force to max_force().
+  void SetForceLimit(double force);
+
+  /// The largest force the gripper accepts (its overdrive force), known
+  /// once calibrated or restored.
+  double max_force() const { return physical_limits_.overdrive_force_; }
+
+  /// Prepares, without sending, the commands that SetPositionAndForce()
+  /// would send for these targets were no deadband to suppress them, for
+  /// ReleaseStagedCommand() to send later in one burst.  Replaces any
+  /// command already staged.  Until the command is released or discarded,
+  /// SetPositionAndForce() must not be called.
+  void StageCommand(double position_mm, double force, ControlMode mode,
+                    double speed_mm_per_s);
+
+  /// Whether a command prepared by StageCommand() awaits release.
+  bool has_staged_command() const { return wsg_->has_staged(); }
+
+  /// Sends the command prepared by StageCommand().  Its grasp profile
+  /// episode starts now, rather than when it was staged.
+  void ReleaseStagedCommand();
+
+  /// Forgets the command prepared by StageCommand(), leaving the gripper
+  /// executing (and the grasp profiler profiling) whatever it was before.
+  void DiscardStagedCommand();
+
   /// Process all available incoming data from the WSG.  This is meant to
   /// be called periodically by a higher-level task loop.
   void Task();
@@ -52,8 +218,53 @@ class PositionForceControl {
   /// twisting, and asymmetric loading of the fingers.
   double force() const;
 
+  /// A callback invoked from within Task() once per status message received.
+  typedef std::function<void(const StatusSample&)> StatusListener;
+
+  /// Registers @p listener to be called with every status sample decoded by
+  /// Task(), in order of receipt.  Listeners run on the caller's thread and
+  /// should be quick, since they delay the processing of later messages.
+  void AddStatusListener(StatusListener listener);
+
+  /// The recent history of status samples, including the one currently being
+  /// delivered to status listeners.
+  const StatusHistory& history() const { return history_; }
+
  private:
+  void RecordStatusSample(const WsgReturnMessage& msg);
+
+  // The finger position on which to base recommand decisions: with
+  // params_.predict_motion, the last reported position rolled forward to
+  // when a command sent now would reach the gripper; otherwise the last
+  // reported position.
+  double DecisionPositionMm() const;
+
+  // The arrival time model of the status stream of @p command, or nullptr if
+  // it is not a periodic status command.
+  ArrivalTimeModel* StatusStreamModel(int command);
+
+  void CommandPrepositionEmulation(double position_mm, double force);
+  void CommandNativeGrasp(double position_mm, double force,
+                          double speed_mm_per_s);
+  void SendNativeGrasp();
+
+  // Tracks the outcome of motion commands issued in kNativeGrasp mode.
+  void HandleMotionResponse(const WsgReturnMessage& msg);
+
   std::unique_ptr<Wsg> wsg_;
+  const ControlParams params_;
+  std::vector<StatusListener> status_listeners_;
+  StatusHistory history_;
+  // One arrival time model per periodic status stream, in the order of
+  // kStatusStreams.
+  std::vector<ArrivalTimeModel> stream_models_;
+  std::unique_ptr<FingerData> fingers_;
+  std::unique_ptr<LoopProbe> loop_probe_;
+  std::unique_ptr<WaitPolicy> wait_policy_;
+  std::unique_ptr<GraspProfiler> grasp_profiler_;
+  WsgMetrics* metrics_ {nullptr};
+  int64_t temperature_period_us_ {0};
+  int64_t last_temperature_poll_us_ {0};
 
   // State of the gripper, according to most recent status messages received;
   // valid only after DoCalibrationSteps().
@@ -62,11 +273,30 @@ class PositionForceControl {
   double last_position_mm_ {0};
   double last_applied_force_ {0};
   double last_speed_mm_per_s_ {0};
+  // Estimated time at which the gripper measured last_position_mm_.
+  int64_t position_acquisition_ns_ {0};
 
   // Current position/force command that the gripper is executing, or has
   // encountered an error while executing.
   double executing_target_position_mm_ {0};
   double executing_force_ {0};
+  double executing_speed_mm_per_s_ {0};
+  ControlMode control_mode_ {kPrepositionEmulation};
+
+  // In kNativeGrasp mode, the motion command (kGrasp, kRelease or
+  // kPrePosition) most recently issued, or zero if none is in effect and the
+  // next target must be commanded regardless of deadbands.
+  int native_command_ {0};
+  // Whether a Grasp should be issued once the in-flight Release completes.
+  bool grasp_after_release_ {false};
+  // Whether the next command must be sent regardless of deadbands.
+  bool recommand_unconditionally_ {false};
+  // While a command is staged, the state to return to if it is discarded,
+  // and the target to profile once it is released.
+  ControllerState unstaged_state_;
+  double staged_position_mm_ {0};
+  double staged_force_ {0};
+  ControlMode staged_mode_ {kPrepositionEmulation};
 
   // Physical limit constants reported by the gripper; valid only after
   // DoCalibrationSteps().
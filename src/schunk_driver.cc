@@ -1,123 +1,346 @@
-#include <cassert>
-#include <ctime>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
 
-#include <math.h>
-#include <unistd.h>
-#include <sys/time.h>
+#include <sys/types.h>
 
 #include <gflags/gflags.h>
 #include <lcm/lcm-cpp.hpp>
 
-#include "drake/lcmt_schunk_wsg_command.hpp"
-#include "drake/lcmt_schunk_wsg_status.hpp"
-
+#include "clock.h"
 #include "defaults.h"
-#include "position_force_control.h"
-#include "wsg.h"
-
-using drake::lcmt_schunk_wsg_command;
-using drake::lcmt_schunk_wsg_status;
+#include "driver_config.h"
+#include "schunk_lcm_client.h"
+#include "state_handoff.h"
+#include "trace.h"
+#include "wsg_tcp_transport.h"
+#include "wsg_udp_transport.h"
 
 namespace {
 
-const char* kLcmStatusChannel = "SCHUNK_WSG_STATUS";
-const char* kLcmCommandChannel = "SCHUNK_WSG_COMMAND";
+// Set by SIGINT or SIGTERM while tracing, so that the trace is completed.
+volatile sig_atomic_t stop_requested = 0;
+
+void RequestStop(int) { stop_requested = 1; }
 
 }  // namespace
 
 DEFINE_string(gripper_addr, schunk_driver::kGripperAddrStr,
               "Address of the gripper to control");
 DEFINE_int32(gripper_port, schunk_driver::kGripperPort,
-             "Gripper UDP port");
+             "Gripper UDP (or TCP) port");
+DEFINE_bool(gripper_tcp, false,
+            "Use the gripper's TCP command interface instead of UDP");
 DEFINE_int32(local_port, schunk_driver::kLocalPort,
              "Local UDP port");
-DEFINE_string(lcm_command_channel, kLcmCommandChannel,
+DEFINE_string(lcm_command_channel, schunk_driver::kLcmCommandChannel,
               "Channel to receive LCM command messages on");
-DEFINE_string(lcm_status_channel, kLcmStatusChannel,
+DEFINE_string(lcm_mode_command_channel,
+              schunk_driver::kLcmModeCommandChannel,
+              "Channel to receive LCM commands that select a control mode on");
+DEFINE_string(lcm_group_command_channel,
+              schunk_driver::kLcmGroupCommandChannel,
+              "Channel to receive commands for several grippers, to be sent "
+              "at a shared release time, on");
+DEFINE_string(lcm_group_release_channel,
+              schunk_driver::kLcmGroupReleaseChannel,
+              "Channel to report the sending of group commands on, and to "
+              "hear the other drivers of each group on");
+DEFINE_int32(group_release_spin_us, 200,
+             "Spin for this long before each group command release time, "
+             "rather than relying on the scheduler to wake the driver on "
+             "time");
+DEFINE_string(lcm_status_channel, schunk_driver::kLcmStatusChannel,
               "Channel to send LCM status messages on");
+DEFINE_string(lcm_status_batch_channel, "",
+              "Channel to send batched multi-sample LCM status messages on; "
+              "if empty, no batched status is sent");
+DEFINE_int32(status_batch_size, 10,
+             "Maximum number of status samples per batched status message");
+DEFINE_int32(status_batch_max_latency_ms, 100,
+             "Maximum age of the oldest sample in a batched status message "
+             "before the batch is sent regardless of its size");
+DEFINE_string(lcm_contact_event_channel, "",
+              "Channel to send contact, part-lost and slip events on; "
+              "if empty, contact detection is disabled");
+DEFINE_double(contact_force, 5,
+              "Force (N) at or above which the fingers are in contact");
+DEFINE_double(release_force, 2,
+              "Force (N) below which contact is broken; must not exceed "
+              "--contact_force");
+DEFINE_double(slip_force_drop, 3,
+              "Force drop (N) within the slip window that indicates slip");
+DEFINE_double(slip_width_change_mm, 1,
+              "Finger travel (mm) within the slip window that indicates slip");
+DEFINE_int32(slip_window_ms, 100, "Time span examined for slip");
+DEFINE_string(lcm_grasp_profile_channel, "",
+              "Channel to send a performance summary of each grasp (or other "
+              "episode of control) on; if empty, episodes are not profiled");
+DEFINE_int32(grasp_settle_ms, 100,
+             "Time the fingers must be still for a profiled episode to end");
+DEFINE_string(lcm_finger_data_channel, "",
+              "Channel to send batched smart finger data on; if empty, "
+              "finger data is not collected");
+DEFINE_int32(finger_data_period_ms, 20,
+             "Minimum period between finger data requests to each finger");
+DEFINE_int32(finger_data_batch_size, 16,
+             "Maximum number of finger data samples per message");
+DEFINE_int32(loop_probe_period_ms, 0,
+             "Period of link round trip probes; 0 disables probing");
+DEFINE_int32(loop_probe_timeout_ms, 500,
+             "Time after which an unanswered link probe counts as lost");
+DEFINE_string(lcm_link_stats_channel, schunk_driver::kLcmLinkStatsChannel,
+              "Channel to send link round trip statistics on");
+DEFINE_double(regrip_force_increment, 0,
+              "Force (N) to add to the commanded force each time slip is "
+              "detected, until the next command arrives; 0 disables regrip");
+DEFINE_int32(metrics_port, 0,
+             "Local TCP port on which to serve OpenMetrics; 0 disables");
+DEFINE_int32(temperature_period_ms, 1000,
+             "Period of gripper temperature reads when serving metrics");
+DEFINE_bool(adaptive_wait, false,
+            "Wait for gripper messages by spinning briefly around each "
+            "expected arrival and blocking otherwise, handling each message "
+            "as it arrives; if false, spin only while awaiting responses and "
+            "sleep between loop iterations");
+DEFINE_int32(spin_before_us, 100,
+             "With --adaptive_wait, start spinning this long before each "
+             "expected message");
+DEFINE_int32(spin_after_us, 400,
+             "With --adaptive_wait, stop spinning this long after each "
+             "expected message");
+DEFINE_int32(response_latency_us, 1000,
+             "With --adaptive_wait, the expected time from sending a command "
+             "to its response, until --loop_probe_period_ms probes measure "
+             "it");
+DEFINE_int32(busy_poll_us, 0,
+             "With --adaptive_wait, kernel busy polling (SO_BUSY_POLL) time "
+             "for the gripper socket; 0 disables");
+DEFINE_string(trace_file, "",
+              "File to which to write a Chrome trace (JSON) of driver ticks "
+              "and gripper messages; empty disables tracing");
+DEFINE_string(config, "",
+              "File of deadbands and periods, as written by autotune; "
+              "empty uses the defaults");
+DEFINE_string(state_shm_name, "",
+              "Shared memory segment (eg /schunk_wsg) in which to mirror "
+              "driver state for a standby; empty disables");
+DEFINE_bool(standby, false,
+            "Wait for the primary driver using --state_shm_name to exit, "
+            "then take over its gripper without recalibrating");
+DEFINE_int32(standby_timeout_ms, 10000,
+             "Time without a heartbeat after which a standby considers a "
+             "still-running primary hung, and kills it before taking over; "
+             "must exceed the longest the primary may block on the gripper "
+             "(up to 6 s, during calibration)");
 
 namespace schunk_driver {
-/// This class implements an LCM endpoint that relays received LCM commands to
-/// the Wsg and receieved Wsg status back over LCM.
-class SchunkLcmClient {
- public:
+namespace {
 
-  SchunkLcmClient()
-      : lcm_(),
-        pf_control_(std::unique_ptr<Wsg>(new Wsg(
-            nullptr, FLAGS_local_port,
-            FLAGS_gripper_addr.c_str(), FLAGS_gripper_port))) {
-    assert(lcm_.good());
+std::unique_ptr<WsgTransport> MakeTransport() {
+  if (FLAGS_gripper_tcp) {
+    return std::unique_ptr<WsgTransport>(new WsgTcpTransport(
+        FLAGS_gripper_addr.c_str(), FLAGS_gripper_port));
   }
+  return std::unique_ptr<WsgTransport>(new WsgUdpTransport(
+      nullptr, FLAGS_local_port,
+      FLAGS_gripper_addr.c_str(), FLAGS_gripper_port));
+}
 
-  ~SchunkLcmClient() {}
-
-  void Initialize() {
-    pf_control_.DoCalibrationSteps();
-    lcm_.subscribe(FLAGS_lcm_command_channel,
-                   &SchunkLcmClient::HandleCommandMessage, this);
-  }
+// Whether process @p pid exists and has not exited (a zombie has, and so
+// no longer holds the gripper port).
+bool ProcessRunning(pid_t pid) {
+  if (pid <= 0 || (kill(pid, 0) != 0 && errno == ESRCH)) { return false; }
+  std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+  std::string contents;
+  if (!std::getline(stat, contents)) { return false; }
+  // The state follows the parenthesized command name.
+  const size_t name_end = contents.rfind(')');
+  return name_end == std::string::npos || name_end + 2 >= contents.size() ||
+      contents[name_end + 2] != 'Z';
+}
 
-  void Task() {
-    // Process all pending messages since our last Task() so that we
-    // only act on the newest.
-    int result = -1;
-    while ((result = lcm_.handleTimeout(0)) > 0) {}
-    assert(result == 0);
-
-    pf_control_.Task();
-    // Schunk only uses positive force; use absolute value of commanded force.
-    pf_control_.SetPositionAndForce(lcm_command_.target_position_mm,
-                                    fabs(lcm_command_.force));
-    lcm_status_.actual_position_mm = pf_control_.position_mm();
-    lcm_status_.actual_speed_mm_per_s = pf_control_.speed_mm_per_s();
-
-    // Schunk returns only scalar force resisting its motion, so invert force
-    // when motion is negative.
-    lcm_status_.actual_force = (pf_control_.speed_mm_per_s() > 0
-                                ? pf_control_.force()
-                                : -pf_control_.force());
-
-    struct timeval tv;
-    gettimeofday(&tv, nullptr);
-    lcm_status_.utime = tv.tv_sec * 1000000L + tv.tv_usec;
-
-    lcm_.publish(FLAGS_lcm_status_channel, &lcm_status_);
-
-    // TODO(ggould-tri) handle finger data and how force measurement changes
-    // with smart fingers (eg, does this switch from force before to after
-    // stiction)
+// Kills @p pid, a primary that has stopped publishing but still exists, and
+// waits up to @p timeout_ns for it to exit, so that the hung primary can
+// never again command the gripper once the standby has taken over.  Returns
+// whether it exited.
+bool FenceHungPrimary(pid_t pid, Clock* clock, int64_t timeout_ns) {
+  std::cerr << "Primary " << pid << " is hung; killing it" << std::endl;
+  if (kill(pid, SIGKILL) != 0 && errno != ESRCH) {
+    std::cerr << "Could not kill primary " << pid << ": " << strerror(errno)
+              << std::endl;
+    return false;
   }
-
- private:
-  void HandleCommandMessage(const lcm::ReceiveBuffer* rbuf,
-                            const std::string& chan,
-                            const lcmt_schunk_wsg_command* command) {
-    lcm_command_ = *command;
+  const int64_t kPollNs = 5000000;
+  const int64_t deadline_ns = clock->MonotonicNs() + timeout_ns;
+  while (ProcessRunning(pid)) {
+    if (clock->MonotonicNs() >= deadline_ns) {
+      std::cerr << "Primary " << pid << " did not exit" << std::endl;
+      return false;
+    }
+    clock->SleepForNs(kPollNs);
   }
+  return true;
+}
 
-  lcm::LCM lcm_;
-  schunk_driver::PositionForceControl pf_control_;
-  lcmt_schunk_wsg_status lcm_status_;
-  lcmt_schunk_wsg_command lcm_command_{};
+// Stops any tracing when main() returns, by whatever path: the flush
+// thread must be joined before static destruction, or the process aborts.
+class StopTracingOnExit {
+ public:
+  ~StopTracingOnExit() { Tracer::Stop(); }
 };
+
+SchunkLcmClientParams ClientParamsFromFlags(const ControlParams& control) {
+  SchunkLcmClientParams params;
+  params.gripper_addr = FLAGS_gripper_addr;
+  params.control = control;
+  params.command_channel = FLAGS_lcm_command_channel;
+  params.mode_command_channel = FLAGS_lcm_mode_command_channel;
+  params.group_command_channel = FLAGS_lcm_group_command_channel;
+  params.group_release_channel = FLAGS_lcm_group_release_channel;
+  params.group_release_spin_ns = FLAGS_group_release_spin_us * 1000L;
+  params.status_channel = FLAGS_lcm_status_channel;
+  params.status_batch_channel = FLAGS_lcm_status_batch_channel;
+  params.status_batch_size = FLAGS_status_batch_size;
+  params.status_batch_max_latency_us =
+      FLAGS_status_batch_max_latency_ms * 1000L;
+  params.contact_event_channel = FLAGS_lcm_contact_event_channel;
+  params.contact.contact_force = FLAGS_contact_force;
+  params.contact.release_force = FLAGS_release_force;
+  params.contact.slip_force_drop = FLAGS_slip_force_drop;
+  params.contact.slip_width_change_mm = FLAGS_slip_width_change_mm;
+  params.contact.slip_window_us = FLAGS_slip_window_ms * 1000L;
+  params.regrip_force_increment = FLAGS_regrip_force_increment;
+  params.grasp_profile_channel = FLAGS_lcm_grasp_profile_channel;
+  params.grasp_profiler.contact_force = FLAGS_contact_force;
+  params.grasp_profiler.settle_time_us = FLAGS_grasp_settle_ms * 1000L;
+  params.finger_data_channel = FLAGS_lcm_finger_data_channel;
+  params.finger_data_period_us = FLAGS_finger_data_period_ms * 1000L;
+  params.finger_data_batch_size = FLAGS_finger_data_batch_size;
+  params.loop_probe_period_us = FLAGS_loop_probe_period_ms * 1000L;
+  params.loop_probe_timeout_us = FLAGS_loop_probe_timeout_ms * 1000L;
+  params.link_stats_channel = FLAGS_lcm_link_stats_channel;
+  params.metrics_port = FLAGS_metrics_port;
+  params.temperature_period_us = FLAGS_temperature_period_ms * 1000L;
+  params.adaptive_wait = FLAGS_adaptive_wait;
+  params.wait_policy.spin_before_ns = FLAGS_spin_before_us * 1000L;
+  params.wait_policy.spin_after_ns = FLAGS_spin_after_us * 1000L;
+  params.wait_policy.response_latency_ns = FLAGS_response_latency_us * 1000L;
+  params.wait_policy.busy_poll_us = FLAGS_busy_poll_us;
+  return params;
+}
+
+}  // namespace
 }  // namespace schunk_driver
 
 
 int main(int argc, char** argv) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
 
-  schunk_driver::SchunkLcmClient client;
-  client.Initialize();
+  if (FLAGS_release_force > FLAGS_contact_force) {
+    // Contact would begin and end on every sample between the two.
+    std::cerr << "--release_force must not exceed --contact_force"
+              << std::endl;
+    return 1;
+  }
+  if (FLAGS_status_batch_size <= 0) {
+    std::cerr << "--status_batch_size must be positive" << std::endl;
+    return 1;
+  }
+
+  schunk_driver::Clock* clock = schunk_driver::SystemClock::Get();
+
+  schunk_driver::DriverConfig config;
+  if (!FLAGS_config.empty() &&
+      !schunk_driver::ReadDriverConfig(FLAGS_config, &config)) {
+    return 1;
+  }
+
+  std::unique_ptr<schunk_driver::StateHandoff> handoff;
+  if (!FLAGS_state_shm_name.empty()) {
+    handoff.reset(new schunk_driver::StateHandoff(FLAGS_state_shm_name));
+  }
+
+  schunk_driver::DriverState restored;
+  bool restore = false;
+  if (FLAGS_standby) {
+    if (!handoff) {
+      std::cerr << "--standby requires --state_shm_name" << std::endl;
+      return 1;
+    }
+    // Wait for a primary to appear, then for it to go.  The primary may hold
+    // the gripper port until it exits, so there is nothing else to prepare.
+    const int64_t kPollNs = 5000000;
+    const int64_t timeout_ns = FLAGS_standby_timeout_ms * 1000000L;
+    std::cout << "Standing by on " << FLAGS_state_shm_name << std::endl;
+    while (!handoff->PrimaryAlive(clock->MonotonicNs(), timeout_ns)) {
+      clock->SleepForNs(kPollNs);
+    }
+    while (handoff->PrimaryAlive(clock->MonotonicNs(), timeout_ns)) {
+      clock->SleepForNs(kPollNs);
+    }
+    // A primary that stopped publishing but still runs may yet command the
+    // gripper, so it must be stopped before this driver takes over.
+    const pid_t primary_pid = handoff->primary_pid();
+    if (schunk_driver::ProcessRunning(primary_pid) &&
+        !schunk_driver::FenceHungPrimary(primary_pid, clock, timeout_ns)) {
+      return 1;
+    }
+    restore = handoff->Read(&restored);
+    if (restore) {
+      std::cout << "Primary gone; taking over" << std::endl;
+    } else {
+      std::cerr << "Primary gone without usable state; recalibrating"
+                << std::endl;
+    }
+  }
+
+  schunk_driver::StopTracingOnExit stop_tracing_on_exit;
+  if (!FLAGS_trace_file.empty()) {
+    try {
+      schunk_driver::Tracer::Start(FLAGS_trace_file);
+    } catch (const std::runtime_error& error) {
+      std::cerr << error.what() << std::endl;
+      return 1;
+    }
+    schunk_driver::Tracer::SetThreadName("driver");
+    signal(SIGINT, &RequestStop);
+    signal(SIGTERM, &RequestStop);
+  }
+
+  // Fails if another driver still holds the gripper port.
+  std::unique_ptr<schunk_driver::WsgTransport> transport;
+  try {
+    transport = schunk_driver::MakeTransport();
+  } catch (const std::runtime_error& error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+
+  lcm::LCM lcm;
+  if (!lcm.good()) {
+    std::cerr << "LCM initialization failed" << std::endl;
+    return 1;
+  }
+  schunk_driver::SchunkLcmClient client(
+      &lcm, std::move(transport), clock, handoff.get(),
+      schunk_driver::ClientParamsFromFlags(config.control));
+  client.Initialize(restore ? &restored : nullptr);
 
-  while (true) {
+  while (!stop_requested) {
     client.Task();
     // Note: too short of a sleep here can put the gripper into some
     // kind of error state.  The right thing to do is probably to
     // directly regulate how quickly we're sending commands, but a
     // 50ms delay on grasping is probably not the end of the world.
-    usleep(50000);
+    // (50ms is the default loop_period_ms; see autotune before changing.)
+    client.ProcessMessagesUntil(
+        clock->NowNs() + config.loop_period_ms * 1000000L);
   }
   return 0;
 }
@@ -0,0 +1,382 @@
+#include "schunk_lcm_client.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+#include "group_release.h"
+#include "trace.h"
+
+using drake::lcmt_schunk_wsg_command;
+using drake::lcmt_schunk_wsg_status;
+
+namespace schunk_driver {
+
+namespace {
+
+// Group commands due further ahead than this are taken to be mistakes (eg a
+// wall clock release time) and rejected, rather than holding the gripper.
+const int64_t kMaxGroupReleaseDelayNs = 10000000000L;
+// Gripper messages are handled until this long before the spin that
+// precedes a group release, so that handling one cannot delay it.
+const int64_t kGroupReleaseGuardNs = 1000000;
+
+}  // namespace
+
+SchunkLcmClient::SchunkLcmClient(
+    lcm::LCM* lcm, std::unique_ptr<WsgTransport> transport, Clock* clock,
+    StateHandoff* handoff, const SchunkLcmClientParams& params)
+    : params_(params),
+      lcm_(lcm),
+      clock_(clock),
+      handoff_(handoff),
+      pf_control_(std::unique_ptr<Wsg>(new Wsg(std::move(transport), clock)),
+                  params.control) {
+  assert(lcm_->good());
+  if (!params_.status_batch_channel.empty()) {
+    status_batcher_.reset(new StatusBatcher(
+        params_.status_batch_size, params_.status_batch_max_latency_us));
+  }
+  if (!params_.contact_event_channel.empty()) {
+    contact_detector_.reset(new ContactDetector(params_.contact));
+  }
+}
+
+
+void SchunkLcmClient::Initialize(const DriverState* restore) {
+  if (!params_.finger_data_channel.empty()) {
+    pf_control_.EnableFingerData(params_.finger_data_period_us,
+                                 params_.finger_data_batch_size);
+  }
+  if (params_.loop_probe_period_us > 0) {
+    pf_control_.EnableLoopProbe(params_.loop_probe_period_us,
+                                params_.loop_probe_timeout_us);
+  }
+  if (!params_.grasp_profile_channel.empty()) {
+    pf_control_.EnableGraspProfiling(
+        params_.grasp_profiler, [this](const GraspProfile& profile) {
+          PublishGraspProfile(profile);
+        });
+  }
+  if (params_.adaptive_wait) {
+    pf_control_.EnableWaitPolicy(params_.wait_policy);
+  }
+  if (params_.metrics_port > 0) {
+    pf_control_.EnableMetrics(&metrics_, params_.temperature_period_us);
+    metrics_server_.reset(new MetricsServer(
+        params_.metrics_port, [this](std::ostream& out) {
+          metrics_.WriteOpenMetrics(params_.gripper_addr, out);
+        }));
+  }
+  if (restore) {
+    pf_control_.RestoreState(restore->controller);
+    lcm_command_.utime = restore->command_utime;
+    lcm_command_.target_position_mm = restore->target_position_mm;
+    lcm_command_.force = restore->force;
+    lcm_command_.speed_mm_per_s = restore->speed_mm_per_s;
+    lcm_command_.control_mode = restore->control_mode;
+    regrip_force_offset_ = restore->regrip_force_offset;
+  } else {
+    pf_control_.DoCalibrationSteps();
+  }
+  lcm_->subscribe(params_.command_channel,
+                  &SchunkLcmClient::HandleCommandMessage, this);
+  lcm_->subscribe(params_.mode_command_channel,
+                  &SchunkLcmClient::HandleModeCommandMessage, this);
+  lcm_->subscribe(params_.group_command_channel,
+                  &SchunkLcmClient::HandleGroupCommandMessage, this);
+  lcm_->subscribe(params_.group_release_channel,
+                  &SchunkLcmClient::HandleGroupReleaseMessage, this);
+  if (status_batcher_) {
+    pf_control_.AddStatusListener([this](const StatusSample& sample) {
+        if (status_batcher_->Add(sample)) {
+          PublishStatusBatch(sample.receive_utime);
+        }
+      });
+  }
+  if (contact_detector_) {
+    pf_control_.AddStatusListener([this](const StatusSample& sample) {
+        HandleStatusSampleForContact(sample);
+      });
+  }
+}
+
+
+void SchunkLcmClient::Task() {
+  TraceSpan span("driver", "Task");
+  const int64_t start_ns = clock_->NowNs();
+
+  // Process all pending messages since our last Task() so that we
+  // only act on the newest.
+  int result = -1;
+  while ((result = lcm_->handleTimeout(0)) > 0) {}
+  assert(result == 0);
+
+  pf_control_.Task();
+  CommandGripper();
+  lcm_status_.actual_position_mm = pf_control_.position_mm();
+  lcm_status_.actual_speed_mm_per_s = pf_control_.speed_mm_per_s();
+
+  // Schunk returns only scalar force resisting its motion, so invert force
+  // when motion is negative.
+  lcm_status_.actual_force = (pf_control_.speed_mm_per_s() > 0
+                              ? pf_control_.force()
+                              : -pf_control_.force());
+
+  lcm_status_.utime = clock_->NowUtime();
+
+  lcm_->publish(params_.status_channel, &lcm_status_);
+
+  if (status_batcher_ && status_batcher_->Expired(lcm_status_.utime)) {
+    PublishStatusBatch(lcm_status_.utime);
+  }
+
+  // Finger data goes out once per tick on its own channel, after the core
+  // status, so that large tactile payloads never delay it.
+  // TODO(ggould-tri) handle how force measurement changes with smart
+  // fingers (eg, does this switch from force before to after stiction)
+  FingerData* fingers = pf_control_.fingers();
+  if (fingers && !fingers->empty()) {
+    lcm_->publish(params_.finger_data_channel,
+                  &fingers->Seal(lcm_status_.utime));
+    fingers->Clear();
+  }
+
+  PublishLinkStats(lcm_status_.utime);
+
+  if (handoff_) {
+    DriverState state;
+    state.controller = pf_control_.GetState();
+    state.command_utime = lcm_command_.utime;
+    state.target_position_mm = lcm_command_.target_position_mm;
+    state.force = lcm_command_.force;
+    state.speed_mm_per_s = lcm_command_.speed_mm_per_s;
+    state.control_mode = lcm_command_.control_mode;
+    state.regrip_force_offset = regrip_force_offset_;
+    handoff_->Publish(state, clock_->MonotonicNs());
+  }
+
+  metrics_.RecordTick(clock_->NowNs() - start_ns);
+}
+
+
+void SchunkLcmClient::ProcessMessagesUntil(int64_t deadline_ns) {
+  if (pf_control_.has_staged_command()) {
+    // Release times are on the monotonic clock, deadlines on the wall
+    // clock.
+    const int64_t release_ns =
+        group_release_.release_ns - clock_->MonotonicNs() + clock_->NowNs();
+    if (release_ns < deadline_ns) {
+      const int64_t handle_until_ns = release_ns - kGroupReleaseGuardNs -
+          params_.group_release_spin_ns;
+      while (pf_control_.WaitForMessage(handle_until_ns)) {
+        pf_control_.Task();
+      }
+      ReleaseGroupCommand();
+    }
+  }
+  while (pf_control_.WaitForMessage(deadline_ns)) {
+    pf_control_.Task();
+  }
+}
+
+
+void SchunkLcmClient::HandleCommandMessage(
+    const lcm::ReceiveBuffer* rbuf, const std::string& chan,
+    const lcmt_schunk_wsg_command* command) {
+  // The newest command wins, even over a group command yet to be sent.
+  pf_control_.DiscardStagedCommand();
+  lcm_command_.utime = command->utime;
+  lcm_command_.target_position_mm = command->target_position_mm;
+  lcm_command_.force = command->force;
+  lcm_command_.speed_mm_per_s = 0;
+  lcm_command_.control_mode =
+      lcmt_schunk_wsg_mode_command::PREPOSITION_EMULATION;
+  regrip_force_offset_ = 0;
+}
+
+
+void SchunkLcmClient::HandleModeCommandMessage(
+    const lcm::ReceiveBuffer* rbuf, const std::string& chan,
+    const lcmt_schunk_wsg_mode_command* command) {
+  pf_control_.DiscardStagedCommand();
+  lcm_command_ = *command;
+  regrip_force_offset_ = 0;
+}
+
+
+void SchunkLcmClient::HandleGroupCommandMessage(
+    const lcm::ReceiveBuffer* rbuf, const std::string& chan,
+    const lcmt_schunk_wsg_group_command* group) {
+  for (int i = 0; i < group->num_grippers; i++) {
+    if (group->gripper_addr[i] != params_.gripper_addr) { continue; }
+    if (group->release_time_ns - clock_->MonotonicNs() >
+        kMaxGroupReleaseDelayNs) {
+      std::cerr << "Group command " << group->group_id
+                << " is due too far ahead; ignoring it" << std::endl;
+      return;
+    }
+    lcm_command_ = group->commands[i];
+    regrip_force_offset_ = 0;
+    group_release_.group_id = group->group_id;
+    group_release_.gripper = params_.gripper_addr;
+    group_release_.num_grippers = group->num_grippers;
+    group_release_.release_ns = group->release_time_ns;
+    pf_control_.StageCommand(
+        lcm_command_.target_position_mm, fabs(lcm_command_.force),
+        CommandedMode(), lcm_command_.speed_mm_per_s);
+    return;
+  }
+}
+
+
+void SchunkLcmClient::HandleGroupReleaseMessage(
+    const lcm::ReceiveBuffer* rbuf, const std::string& chan,
+    const lcmt_schunk_wsg_group_release* msg) {
+  GroupRelease release;
+  release.group_id = msg->group_id;
+  release.gripper = msg->gripper_addr;
+  release.num_grippers = msg->num_grippers;
+  release.release_ns = msg->release_time_ns;
+  release.send_ns = msg->send_start_ns;
+  RecordGroupRelease(release);
+}
+
+
+void SchunkLcmClient::ReleaseGroupCommand() {
+  const int64_t start_ns = clock_->WaitUntilMonotonicNs(
+      group_release_.release_ns, params_.group_release_spin_ns);
+  pf_control_.ReleaseStagedCommand();
+  const int64_t end_ns = clock_->MonotonicNs();
+  group_release_.send_ns = start_ns;
+  metrics_.RecordGroupRelease(start_ns - group_release_.release_ns);
+
+  lcmt_schunk_wsg_group_release msg{};
+  msg.utime = clock_->NowUtime();
+  msg.group_id = group_release_.group_id;
+  msg.gripper_addr = params_.gripper_addr;
+  msg.num_grippers = group_release_.num_grippers;
+  msg.release_time_ns = group_release_.release_ns;
+  msg.send_start_ns = start_ns;
+  msg.send_end_ns = end_ns;
+  lcm_->publish(params_.group_release_channel, &msg);
+  // Our own report may or may not come back to us over LCM.
+  RecordGroupRelease(group_release_);
+}
+
+
+void SchunkLcmClient::RecordGroupRelease(const GroupRelease& release) {
+  GroupSkew skew;
+  if (group_skew_tracker_.Add(release, &skew)) {
+    metrics_.RecordGroupSkew(skew.skew_ns);
+  }
+}
+
+
+PositionForceControl::ControlMode SchunkLcmClient::CommandedMode() const {
+  return (lcm_command_.control_mode ==
+          lcmt_schunk_wsg_mode_command::NATIVE_GRASP)
+      ? PositionForceControl::kNativeGrasp
+      : PositionForceControl::kPrepositionEmulation;
+}
+
+
+void SchunkLcmClient::CommandGripper() {
+  if (pf_control_.has_staged_command()) { return; }
+  // Schunk only uses positive force; use absolute value of commanded force.
+  pf_control_.SetPositionAndForce(
+      lcm_command_.target_position_mm,
+      fabs(lcm_command_.force) + regrip_force_offset_,
+      CommandedMode(), lcm_command_.speed_mm_per_s);
+}
+
+
+void SchunkLcmClient::HandleStatusSampleForContact(
+    const StatusSample& sample) {
+  ContactEvent event;
+  if (!contact_detector_->Update(sample, pf_control_.history(), &event)) {
+    return;
+  }
+  lcmt_schunk_wsg_contact_event msg{};
+  msg.utime = clock_->NowUtime();
+  msg.sample_utime = event.sample_utime;
+  msg.event_type = static_cast<int8_t>(event.type);
+  msg.actual_position_mm = event.position_mm;
+  msg.actual_force = event.force;
+  msg.force_drop = event.force_drop;
+  msg.width_change_mm = event.width_change_mm;
+  msg.grasping_state = static_cast<int8_t>(event.grasping_state);
+  lcm_->publish(params_.contact_event_channel, &msg);
+
+  // Beyond the gripper's maximum force, another slip can only be reported.
+  const double max_offset = pf_control_.max_force() - fabs(lcm_command_.force);
+  if (event.type == ContactEvent::kSlip &&
+      params_.regrip_force_increment > 0 &&
+      regrip_force_offset_ < max_offset) {
+    regrip_force_offset_ = std::min(
+        regrip_force_offset_ + params_.regrip_force_increment, max_offset);
+    // Increments are typically smaller than the force deadband, which
+    // would otherwise hold the force limit where it was.
+    if (!pf_control_.has_staged_command()) {
+      pf_control_.SetForceLimit(
+          fabs(lcm_command_.force) + regrip_force_offset_);
+    }
+  }
+}
+
+
+void SchunkLcmClient::PublishLinkStats(int64_t now_utime) {
+  const LoopProbe* probe = pf_control_.loop_probe();
+  if (!probe) { return; }
+  const LoopProbe::Stats stats = probe->GetStats();
+  if (stats.sent == last_published_probe_count_) { return; }
+  last_published_probe_count_ = stats.sent;
+  lcmt_schunk_wsg_link_stats msg{};
+  msg.utime = now_utime;
+  msg.gripper_addr = params_.gripper_addr;
+  msg.probes_sent = stats.sent;
+  msg.probes_received = stats.received;
+  msg.probes_lost = stats.lost;
+  msg.rtt_min_us = stats.min_us;
+  msg.rtt_p50_us = stats.p50_us;
+  msg.rtt_p99_us = stats.p99_us;
+  msg.rtt_last_us = stats.last_us;
+  lcm_->publish(params_.link_stats_channel, &msg);
+}
+
+
+void SchunkLcmClient::PublishGraspProfile(const GraspProfile& profile) {
+  lcmt_schunk_wsg_grasp_profile msg{};
+  msg.utime = clock_->NowUtime();
+  msg.gripper_addr = params_.gripper_addr;
+  msg.start_utime = profile.start_utime;
+  msg.duration_us = profile.end_utime - profile.start_utime;
+  msg.target_position_mm = profile.target_position_mm;
+  msg.target_force = profile.target_force;
+  msg.control_mode = static_cast<int8_t>(profile.control_mode);
+  msg.settled = profile.settled;
+  msg.time_to_contact_us = profile.time_to_contact_us;
+  msg.time_to_holding_us = profile.time_to_holding_us;
+  msg.final_position_mm = profile.final_position_mm;
+  msg.peak_force = profile.peak_force;
+  msg.final_grasping_state =
+      static_cast<int8_t>(profile.final_grasping_state);
+  msg.num_preposition_commands = profile.prepositions;
+  msg.num_force_limit_commands = profile.force_limits;
+  msg.num_grasp_commands = profile.grasps;
+  msg.num_release_commands = profile.releases;
+  msg.firmware_grasps = profile.firmware_grasps;
+  msg.firmware_no_part_found = profile.firmware_no_part_found;
+  msg.firmware_part_lost = profile.firmware_part_lost;
+  lcm_->publish(params_.grasp_profile_channel, &msg);
+}
+
+
+void SchunkLcmClient::PublishStatusBatch(int64_t now_utime) {
+  lcm_->publish(params_.status_batch_channel,
+                &status_batcher_->Seal(now_utime));
+  status_batcher_->Clear();
+}
+
+}  // namespace schunk_driver
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <lcm/lcm-cpp.hpp>
+
+#include "drake/lcmt_schunk_wsg_command.hpp"
+#include "drake/lcmt_schunk_wsg_status.hpp"
+#include "schunk_driver/lcmt_schunk_wsg_contact_event.hpp"
+#include "schunk_driver/lcmt_schunk_wsg_finger_data.hpp"
+#include "schunk_driver/lcmt_schunk_wsg_grasp_profile.hpp"
+#include "schunk_driver/lcmt_schunk_wsg_group_command.hpp"
+#include "schunk_driver/lcmt_schunk_wsg_group_release.hpp"
+#include "schunk_driver/lcmt_schunk_wsg_link_stats.hpp"
+#include "schunk_driver/lcmt_schunk_wsg_mode_command.hpp"
+#include "schunk_driver/lcmt_schunk_wsg_status_batch.hpp"
+
+#include "clock.h"
+#include "contact_detector.h"
+#include "defaults.h"
+#include "grasp_profiler.h"
+#include "group_release.h"
+#include "metrics_server.h"
+#include "position_force_control.h"
+#include "state_handoff.h"
+#include "status_batcher.h"
+#include "wait_policy.h"
+#include "wsg_metrics.h"
+#include "wsg_transport.h"
+
+namespace schunk_driver {
+
+// Default LCM channels.
+const static char* kLcmStatusChannel = "SCHUNK_WSG_STATUS";
+const static char* kLcmCommandChannel = "SCHUNK_WSG_COMMAND";
+const static char* kLcmModeCommandChannel = "SCHUNK_WSG_MODE_COMMAND";
+const static char* kLcmLinkStatsChannel = "SCHUNK_WSG_LINK_STATS";
+const static char* kLcmGroupCommandChannel = "SCHUNK_WSG_GROUP_COMMAND";
+const static char* kLcmGroupReleaseChannel = "SCHUNK_WSG_GROUP_RELEASE";
+
+/// Configuration of SchunkLcmClient.  schunk_driver sets each field from
+/// the command line flag of the same name, which documents it; an empty
+/// channel disables the feature that publishes on it.
+struct SchunkLcmClientParams {
+  /// Identifies this gripper in group commands and published messages.
+  std::string gripper_addr {kGripperAddrStr};
+  ControlParams control;
+
+  std::string command_channel {kLcmCommandChannel};
+  std::string mode_command_channel {kLcmModeCommandChannel};
+  std::string group_command_channel {kLcmGroupCommandChannel};
+  std::string group_release_channel {kLcmGroupReleaseChannel};
+  int64_t group_release_spin_ns {200000};
+
+  std::string status_channel {kLcmStatusChannel};
+  std::string status_batch_channel;
+  int status_batch_size {10};
+  int64_t status_batch_max_latency_us {100000};
+
+  std::string contact_event_channel;
+  ContactDetectorParams contact;
+  /// Force (N) added to the commanded force on each slip; 0 disables.
+  double regrip_force_increment {0};
+
+  std::string grasp_profile_channel;
+  GraspProfilerParams grasp_profiler;
+
+  std::string finger_data_channel;
+  int64_t finger_data_period_us {20000};
+  int finger_data_batch_size {16};
+
+  /// Period of link round trip probes; 0 disables probing.
+  int64_t loop_probe_period_us {0};
+  int64_t loop_probe_timeout_us {500000};
+  std::string link_stats_channel {kLcmLinkStatsChannel};
+
+  /// Local TCP port on which to serve OpenMetrics; 0 disables.
+  int metrics_port {0};
+  int64_t temperature_period_us {1000000};
+
+  /// Whether to wait for gripper messages with a WaitPolicy.
+  bool adaptive_wait {false};
+  WaitPolicyParams wait_policy;
+};
+
+/// This class implements an LCM endpoint that relays received LCM commands to
+/// the Wsg and receieved Wsg status back over LCM.
+class SchunkLcmClient {
+ public:
+  /// Relays between @p lcm and the gripper at the other end of
+  /// @p transport, taking all times and waits from @p clock.  @p lcm and
+  /// @p clock must outlive this object.  If @p handoff is not null, mirrors
+  /// driver state into it every Task().
+  SchunkLcmClient(lcm::LCM* lcm, std::unique_ptr<WsgTransport> transport,
+                  Clock* clock, StateHandoff* handoff,
+                  const SchunkLcmClientParams& params);
+
+  ~SchunkLcmClient() {}
+
+  /// Calibrates the gripper, or if @p restore is not null resumes from the
+  /// state a previous driver handed off.
+  void Initialize(const DriverState* restore);
+
+  /// Handles pending LCM commands and gripper messages, commands the
+  /// gripper and publishes its status.
+  void Task();
+
+  /// Handles messages from the gripper until @p deadline_ns, each as it
+  /// arrives if waiting adaptively, so that contact detection and batched
+  /// status see it promptly.  Otherwise just sleeps.  Sends a staged group
+  /// command at its release time if that comes first.
+  void ProcessMessagesUntil(int64_t deadline_ns);
+
+ private:
+  void HandleCommandMessage(const lcm::ReceiveBuffer* rbuf,
+                            const std::string& chan,
+                            const drake::lcmt_schunk_wsg_command* command);
+
+  void HandleModeCommandMessage(const lcm::ReceiveBuffer* rbuf,
+                                const std::string& chan,
+                                const lcmt_schunk_wsg_mode_command* command);
+
+  // Stages this driver's part of a group command, to be sent by
+  // ProcessMessagesUntil() at the group's release time.
+  void HandleGroupCommandMessage(
+      const lcm::ReceiveBuffer* rbuf, const std::string& chan,
+      const lcmt_schunk_wsg_group_command* group);
+
+  // Records another driver's (or our own) report of a group release, and
+  // the group's skew once every driver has reported.
+  void HandleGroupReleaseMessage(
+      const lcm::ReceiveBuffer* rbuf, const std::string& chan,
+      const lcmt_schunk_wsg_group_release* msg);
+
+  // Sends the staged group command at its release time and reports when.
+  void ReleaseGroupCommand();
+
+  void RecordGroupRelease(const GroupRelease& release);
+
+  // The control mode of the most recent command.
+  PositionForceControl::ControlMode CommandedMode() const;
+
+  // Relays the most recent command from any command channel, unless a group
+  // command awaits its release time.
+  void CommandGripper();
+
+  // Runs contact detection on a single status sample, publishing any event
+  // immediately rather than waiting for the next Task().
+  void HandleStatusSampleForContact(const StatusSample& sample);
+
+  // Publishes link statistics whenever a new probe has gone out.
+  void PublishLinkStats(int64_t now_utime);
+
+  void PublishGraspProfile(const GraspProfile& profile);
+
+  void PublishStatusBatch(int64_t now_utime);
+
+  const SchunkLcmClientParams params_;
+  lcm::LCM* const lcm_;
+  Clock* const clock_;
+  StateHandoff* const handoff_;
+  WsgMetrics metrics_;
+  PositionForceControl pf_control_;
+  drake::lcmt_schunk_wsg_status lcm_status_;
+  lcmt_schunk_wsg_mode_command lcm_command_{};
+  std::unique_ptr<StatusBatcher> status_batcher_;
+  std::unique_ptr<ContactDetector> contact_detector_;
+  // Extra force added in response to detected slip since the last command.
+  double regrip_force_offset_ {0};
+  uint64_t last_published_probe_count_ {0};
+  // The group command most recently staged or released.
+  GroupRelease group_release_;
+  GroupSkewTracker group_skew_tracker_;
+  std::unique_ptr<MetricsServer> metrics_server_;
+};
+
+}  // namespace schunk_driver
@@ -0,0 +1,311 @@
+/// Python bindings for talking to a gripper in-process, without the LCM
+/// round trip through schunk_driver.  Names follow the C++ API.
+///
+///   import schunk_wsg
+///   control = schunk_wsg.PositionForceControl("192.168.1.20")
+///   control.DoCalibrationSteps()
+///   control.SetPositionAndForce(50, 20)
+///   for batch in control.Status():
+///     print(batch["position_mm"])
+///
+/// Status arrives in batches of NumPy arrays, one per field, so that the
+/// cost per sample is a column append in C++ rather than a Python object.
+///
+/// Calls that wait on the gripper run without the GIL, and each object
+/// serializes them with a mutex, so Python threads may share an object.
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+#include "clock.h"
+#include "position_force_control.h"
+#include "wsg.h"
+#include "wsg_tcp_transport.h"
+#include "wsg_udp_transport.h"
+
+namespace py = pybind11;
+
+namespace schunk_driver {
+namespace {
+
+std::unique_ptr<Wsg> MakeWsg(const std::string& gripper_addr,
+                             int gripper_port, int local_port, bool tcp) {
+  std::unique_ptr<WsgTransport> transport;
+  if (tcp) {
+    transport.reset(new WsgTcpTransport(gripper_addr.c_str(), gripper_port));
+  } else {
+    transport.reset(new WsgUdpTransport(
+        nullptr, local_port, gripper_addr.c_str(), gripper_port));
+  }
+  return std::unique_ptr<Wsg>(new Wsg(std::move(transport),
+                                      SystemClock::Get()));
+}
+
+template <typename T>
+py::array_t<T> ToArray(const std::vector<T>& values) {
+  return py::array_t<T>(values.size(), values.data());
+}
+
+/// A Wsg whose calls, made without the GIL, take turns.
+class LockedWsg {
+ public:
+  LockedWsg(const std::string& gripper_addr, int gripper_port,
+            int local_port, bool tcp)
+      : wsg_(MakeWsg(gripper_addr, gripper_port, local_port, tcp)) {}
+
+  /// Calls @p method of the Wsg with @p args under the lock.
+  template <typename Result, typename... Params, typename... Args>
+  Result Call(Result (Wsg::*method)(Params...), Args... args) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (wsg_.get()->*method)(args...);
+  }
+
+ private:
+  std::mutex mutex_;
+  const std::unique_ptr<Wsg> wsg_;
+};
+
+/// A PositionForceControl that also accumulates its status samples as
+/// columns, to be handed to Python a batch at a time.  Only PollStatus()
+/// collects samples; Task() discards them, so that a caller that never
+/// polls status does not accumulate it without bound.
+///
+/// Methods take the object's mutex only without the GIL, lest a thread
+/// holding the GIL wait on one that holds the mutex.
+class ControlWithStatus {
+ public:
+  ControlWithStatus(const std::string& gripper_addr, int gripper_port,
+                    int local_port, bool tcp)
+      : control_(MakeWsg(gripper_addr, gripper_port, local_port, tcp)) {
+    control_.AddStatusListener([this](const StatusSample& sample) {
+        columns_.receive_utime.push_back(sample.receive_utime);
+        columns_.acquisition_utime.push_back(sample.acquisition_utime);
+        columns_.command.push_back(sample.command);
+        columns_.position_mm.push_back(sample.position_mm);
+        columns_.speed_mm_per_s.push_back(sample.speed_mm_per_s);
+        columns_.force.push_back(sample.force);
+        columns_.system_state.push_back(sample.system_state);
+        columns_.grasping_state.push_back(
+            static_cast<int8_t>(sample.grasping_state));
+      });
+  }
+
+  /// Calls @p function with the PositionForceControl under the lock.
+  template <typename Function>
+  auto Call(Function function) -> decltype(function(
+      std::declval<PositionForceControl&>())) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return function(control_);
+  }
+
+  /// Runs Task(), discarding the samples it decodes.
+  void Task() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    control_.Task();
+    columns_.Clear();
+  }
+
+  /// Runs Task() and returns the samples it decoded as a dict of arrays,
+  /// or None if there were none.  Call with the GIL held.
+  py::object PollStatus() {
+    Columns columns;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(mutex_);
+      control_.Task();
+      std::swap(columns, columns_);
+    }
+    if (columns.receive_utime.empty()) { return py::none(); }
+    py::dict batch;
+    batch["receive_utime"] = ToArray(columns.receive_utime);
+    batch["acquisition_utime"] = ToArray(columns.acquisition_utime);
+    batch["command"] = ToArray(columns.command);
+    batch["position_mm"] = ToArray(columns.position_mm);
+    batch["speed_mm_per_s"] = ToArray(columns.speed_mm_per_s);
+    batch["force"] = ToArray(columns.force);
+    batch["system_state"] = ToArray(columns.system_state);
+    batch["grasping_state"] = ToArray(columns.grasping_state);
+    return std::move(batch);
+  }
+
+ private:
+  struct Columns {
+    void Clear() {
+      receive_utime.clear();
+      acquisition_utime.clear();
+      command.clear();
+      position_mm.clear();
+      speed_mm_per_s.clear();
+      force.clear();
+      system_state.clear();
+      grasping_state.clear();
+    }
+
+    std::vector<int64_t> receive_utime;
+    std::vector<int64_t> acquisition_utime;
+    std::vector<int32_t> command;
+    std::vector<double> position_mm;
+    std::vector<double> speed_mm_per_s;
+    std::vector<double> force;
+    std::vector<uint32_t> system_state;
+    std::vector<int8_t> grasping_state;
+  };
+
+  // Guards control_ and columns_, which its status listener appends to.
+  std::mutex mutex_;
+  PositionForceControl control_;
+  Columns columns_;
+};
+
+/// Iterates over status batches until none is pending; never blocks.
+class StatusIterator {
+ public:
+  explicit StatusIterator(ControlWithStatus* control) : control_(control) {}
+
+  py::object Next() {
+    py::object batch = control_->PollStatus();
+    if (batch.is_none()) { throw py::stop_iteration(); }
+    return batch;
+  }
+
+ private:
+  ControlWithStatus* const control_;
+};
+
+}  // namespace
+}  // namespace schunk_driver
+
+PYBIND11_MODULE(schunk_wsg, m) {
+  using namespace schunk_driver;
+  m.doc() = "In-process access to a Schunk WSG gripper.";
+
+  py::class_<SystemInfo>(m, "SystemInfo")
+      .def_readonly("type", &SystemInfo::type_)
+      .def_readonly("hwrev", &SystemInfo::hwrev_)
+      .def_readonly("fw_version", &SystemInfo::fw_version_)
+      .def_readonly("serial_number", &SystemInfo::serial_number_);
+
+  py::class_<PhysicalLimits>(m, "PhysicalLimits")
+      .def_readonly("stroke_mm", &PhysicalLimits::stroke_mm_)
+      .def_readonly("min_speed_mm_per_s", &PhysicalLimits::min_speed_mm_per_s_)
+      .def_readonly("max_speed_mm_per_s", &PhysicalLimits::max_speed_mm_per_s_)
+      .def_readonly("min_acc_mm_per_ss", &PhysicalLimits::min_acc_mm_per_ss_)
+      .def_readonly("max_acc_mm_per_ss", &PhysicalLimits::max_acc_mm_per_ss_)
+      .def_readonly("min_force", &PhysicalLimits::min_force_)
+      .def_readonly("nominal_force", &PhysicalLimits::nominal_force_)
+      .def_readonly("overdrive_force", &PhysicalLimits::overdrive_force_);
+
+  // Calls that wait on the gripper, or on another thread's call, release
+  // the GIL so that other Python threads keep running.
+  using release_gil = py::call_guard<py::gil_scoped_release>;
+
+  py::class_<LockedWsg> wsg(m, "Wsg");
+  py::enum_<Wsg::HomeDirection>(wsg, "HomeDirection")
+      .value("kDefault", Wsg::kDefault)
+      .value("kPositive", Wsg::kPositive)
+      .value("kNegative", Wsg::kNegative);
+  py::enum_<Wsg::PrepositionStopMode>(wsg, "PrepositionStopMode")
+      .value("kPrepositionClampOnBlock", Wsg::kPrepositionClampOnBlock)
+      .value("kPrepositionStopOnBlock", Wsg::kPrepositionStopOnBlock);
+  py::enum_<Wsg::PrepositionMoveMode>(wsg, "PrepositionMoveMode")
+      .value("kPrepositionAbsolute", Wsg::kPrepositionAbsolute)
+      .value("kPrepositionRelative", Wsg::kPrepositionRelative);
+  wsg.def(py::init<const std::string&, int, int, bool>(),
+          py::arg("gripper_addr") = kGripperAddrStr,
+          py::arg("gripper_port") = kGripperPort,
+          py::arg("local_port") = kLocalPort,
+          py::arg("tcp") = false)
+      .def("Home", [](LockedWsg& self, Wsg::HomeDirection direction) {
+          return self.Call(&Wsg::Home, direction);
+        }, py::arg("direction"), release_gil())
+      .def("Grasp", [](LockedWsg& self, double width_mm,
+                       double speed_mm_per_s) {
+          return self.Call(&Wsg::Grasp, width_mm, speed_mm_per_s);
+        }, py::arg("width_mm"), py::arg("speed_mm_per_s"), release_gil())
+      .def("Preposition", [](LockedWsg& self,
+                             Wsg::PrepositionStopMode stop_mode,
+                             Wsg::PrepositionMoveMode move_mode,
+                             float width_mm, float speed_mm_per_s) {
+          return self.Call(&Wsg::Preposition, stop_mode, move_mode,
+                           width_mm, speed_mm_per_s);
+        },
+        py::arg("stop_mode"), py::arg("move_mode"),
+        py::arg("width_mm"), py::arg("speed_mm_per_s"), release_gil())
+      .def("Stop", [](LockedWsg& self) {
+          self.Call(&Wsg::Stop);
+        }, release_gil())
+      .def("GetSystemInfo", [](LockedWsg& self) {
+          return self.Call(&Wsg::GetSystemInfo);
+        }, release_gil())
+      .def("GetPhysicalLimits", [](LockedWsg& self) {
+          return self.Call(&Wsg::GetPhysicalLimits);
+        }, release_gil());
+
+  py::class_<StatusIterator>(m, "StatusIterator")
+      .def("__iter__", [](StatusIterator& self) -> StatusIterator& {
+          return self;
+        }, py::return_value_policy::reference_internal)
+      .def("__next__", &StatusIterator::Next);
+
+  py::class_<ControlWithStatus> control(m, "PositionForceControl");
+  py::enum_<PositionForceControl::ControlMode>(control, "ControlMode")
+      .value("kPrepositionEmulation",
+             PositionForceControl::kPrepositionEmulation)
+      .value("kNativeGrasp", PositionForceControl::kNativeGrasp);
+  control
+      .def(py::init<const std::string&, int, int, bool>(),
+           py::arg("gripper_addr") = kGripperAddrStr,
+           py::arg("gripper_port") = kGripperPort,
+           py::arg("local_port") = kLocalPort,
+           py::arg("tcp") = false)
+      .def("DoCalibrationSteps", [](ControlWithStatus& self) {
+          self.Call([](PositionForceControl& control) {
+              control.DoCalibrationSteps();
+            });
+        }, release_gil())
+      .def("SetPositionAndForce", [](ControlWithStatus& self,
+                                     double position_mm, double force,
+                                     PositionForceControl::ControlMode mode,
+                                     double speed_mm_per_s) {
+          self.Call([&](PositionForceControl& control) {
+              control.SetPositionAndForce(position_mm, force, mode,
+                                          speed_mm_per_s);
+            });
+        },
+        py::arg("position_mm"), py::arg("force"),
+        py::arg("mode") = PositionForceControl::kPrepositionEmulation,
+        py::arg("speed_mm_per_s") = 0, release_gil())
+      .def("Task", &ControlWithStatus::Task, release_gil(),
+           "Processes pending messages, discarding their status samples; "
+           "use PollStatus or Status to collect them instead.")
+      .def("position_mm", [](ControlWithStatus& self) {
+          return self.Call([](PositionForceControl& control) {
+              return control.position_mm();
+            });
+        }, release_gil())
+      .def("speed_mm_per_s", [](ControlWithStatus& self) {
+          return self.Call([](PositionForceControl& control) {
+              return control.speed_mm_per_s();
+            });
+        }, release_gil())
+      .def("force", [](ControlWithStatus& self) {
+          return self.Call([](PositionForceControl& control) {
+              return control.force();
+            });
+        }, release_gil())
+      .def("PollStatus", &ControlWithStatus::PollStatus,
+           "Processes pending messages and returns their status samples as "
+           "a dict of NumPy arrays, or None if there were none.")
+      .def("Status", [](ControlWithStatus& self) {
+          return StatusIterator(&self);
+        }, py::keep_alive<0, 1>(),
+        "Iterates over status batches (see PollStatus) until none is "
+        "pending.");
+}
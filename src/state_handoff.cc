@@ -0,0 +1,112 @@
+#include "state_handoff.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace schunk_driver {
+namespace {
+
+// Identifies a segment written by this version of the segment and of
+// DriverState.  Version 2 stamps heartbeats on the monotonic clock.
+const uint64_t kMagic = 0x5753474861646f32ULL + sizeof(DriverState);
+
+}  // namespace
+
+struct StateHandoff::Segment {
+  std::atomic<uint64_t> magic;
+  std::atomic<uint64_t> sequence;
+  std::atomic<int64_t> heartbeat_monotonic_ns;
+  std::atomic<int32_t> primary_pid;
+  DriverState state;
+};
+
+StateHandoff::StateHandoff(const std::string& name) : name_(name) {
+  const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0660);
+  if (fd < 0) {
+    throw std::runtime_error("shm_open " + name + " failed: " +
+                             strerror(errno));
+  }
+  // A new segment is zero-filled, which reads as never published.
+  if (ftruncate(fd, sizeof(Segment)) != 0) {
+    close(fd);
+    throw std::runtime_error("Sizing " + name + " failed: " +
+                             strerror(errno));
+  }
+  void* address = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    throw std::runtime_error("Mapping " + name + " failed: " +
+                             strerror(errno));
+  }
+  segment_ = static_cast<Segment*>(address);
+}
+
+StateHandoff::~StateHandoff() {
+  munmap(segment_, sizeof(Segment));
+}
+
+void StateHandoff::Publish(const DriverState& state,
+                           int64_t monotonic_ns) {
+  const uint64_t sequence =
+      segment_->sequence.load(std::memory_order_relaxed);
+  segment_->sequence.store(sequence | 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(&segment_->state, &state, sizeof(state));
+  segment_->sequence.store((sequence | 1) + 1, std::memory_order_release);
+
+  segment_->primary_pid.store(getpid(), std::memory_order_relaxed);
+  segment_->heartbeat_monotonic_ns.store(monotonic_ns,
+                                          std::memory_order_relaxed);
+  segment_->magic.store(kMagic, std::memory_order_release);
+}
+
+bool StateHandoff::Read(DriverState* state) const {
+  if (segment_->magic.load(std::memory_order_acquire) != kMagic) {
+    return false;
+  }
+  // A primary that died mid-write leaves the count odd forever, so give up
+  // eventually rather than spin.
+  const int kMaxAttempts = 100000;
+  for (int i = 0; i < kMaxAttempts; i++) {
+    const uint64_t before = segment_->sequence.load(std::memory_order_acquire);
+    if (before & 1) { continue; }
+    memcpy(state, &segment_->state, sizeof(*state));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (segment_->sequence.load(std::memory_order_relaxed) == before) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool StateHandoff::PrimaryAlive(int64_t monotonic_ns,
+                                int64_t timeout_ns) const {
+  if (segment_->magic.load(std::memory_order_acquire) != kMagic) {
+    return false;
+  }
+  const pid_t pid = segment_->primary_pid.load(std::memory_order_relaxed);
+  if (kill(pid, 0) != 0 && errno == ESRCH) {
+    return false;
+  }
+  return monotonic_ns -
+      segment_->heartbeat_monotonic_ns.load(std::memory_order_relaxed) <
+      timeout_ns;
+}
+
+int32_t StateHandoff::primary_pid() const {
+  if (segment_->magic.load(std::memory_order_acquire) != kMagic) {
+    return 0;
+  }
+  return segment_->primary_pid.load(std::memory_order_relaxed);
+}
+
+}  // namespace schunk_driver
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "position_force_control.h"
+
+namespace schunk_driver {
+
+/// The state a driver hands to its standby: the controller's, and the
+/// command it is relaying.
+struct DriverState {
+  ControllerState controller;
+  int64_t command_utime {0};
+  double target_position_mm {0};
+  double force {0};
+  double speed_mm_per_s {0};
+  int control_mode {0};
+  double regrip_force_offset {0};
+};
+
+/// Mirrors a primary driver's DriverState, with a heartbeat, into a POSIX
+/// shared memory segment, so that a standby driver on the same host can take
+/// over the gripper without recalibrating it.
+///
+/// There is one writer (the primary) and any number of readers; readers
+/// never block it.  Writes are guarded by a sequence counter that is odd
+/// while a write is in progress, and readers retry until they copy a state
+/// with the same even count before and after.
+class StateHandoff {
+ public:
+  /// Opens (creating if need be) the segment named @p name, which should
+  /// begin with '/'.  Throws std::runtime_error on failure.
+  explicit StateHandoff(const std::string& name);
+
+  ~StateHandoff();
+
+  /// Records @p state, and the calling process as the live primary as of
+  /// @p monotonic_ns on the host's monotonic clock (Clock::MonotonicNs()),
+  /// which every process on the host shares and no wall clock step moves.
+  void Publish(const DriverState& state, int64_t monotonic_ns);
+
+  /// Copies the most recently published state into @p state, returning
+  /// false if none has ever been published or the last write never
+  /// completed.
+  bool Read(DriverState* state) const;
+
+  /// Whether a primary has published within @p timeout_ns of the monotonic
+  /// time @p monotonic_ns and its process still exists.  A primary that
+  /// exits is noticed immediately; one that hangs, only after the timeout.
+  bool PrimaryAlive(int64_t monotonic_ns, int64_t timeout_ns) const;
+
+  /// The process id of the last primary to publish, or 0 if none has.
+  int32_t primary_pid() const;
+
+ private:
+  struct Segment;
+
+  const std::string name_;
+  Segment* segment_ {nullptr};
+};
+
+}  // namespace schunk_driver
@@ -0,0 +1,59 @@
+#include "status_batcher.h"
+
+#include <cassert>
+
+namespace schunk_driver {
+
+StatusBatcher::StatusBatcher(int max_samples, int64_t max_latency_us)
+    : max_samples_(max_samples),
+      max_latency_us_(max_latency_us) {
+  assert(max_samples_ > 0);
+  // Reserve the full batch up front so that Add() never allocates.
+  batch_.sample_utime.reserve(max_samples_);
+  batch_.acquisition_utime.reserve(max_samples_);
+  batch_.actual_position_mm.reserve(max_samples_);
+  batch_.actual_speed_mm_per_s.reserve(max_samples_);
+  batch_.actual_force.reserve(max_samples_);
+  batch_.system_state.reserve(max_samples_);
+  batch_.grasping_state.reserve(max_samples_);
+  Clear();
+}
+
+bool StatusBatcher::Add(const StatusSample& sample) {
+  assert(batch_.num_samples < max_samples_);
+  batch_.sample_utime.push_back(sample.receive_utime);
+  batch_.acquisition_utime.push_back(sample.acquisition_utime);
+  batch_.actual_position_mm.push_back(sample.position_mm);
+  batch_.actual_speed_mm_per_s.push_back(sample.speed_mm_per_s);
+  // Schunk returns only scalar force resisting its motion, so invert force
+  // when motion is negative (as for the single-sample status message).
+  batch_.actual_force.push_back(
+      sample.speed_mm_per_s > 0 ? sample.force : -sample.force);
+  batch_.system_state.push_back(static_cast<int32_t>(sample.system_state));
+  batch_.grasping_state.push_back(static_cast<int8_t>(sample.grasping_state));
+  batch_.num_samples++;
+  return batch_.num_samples >= max_samples_;
+}
+
+bool StatusBatcher::Expired(int64_t now_utime) const {
+  return !empty() &&
+      (now_utime - batch_.sample_utime.front()) >= max_latency_us_;
+}
+
+const lcmt_schunk_wsg_status_batch& StatusBatcher::Seal(int64_t now_utime) {
+  batch_.utime = now_utime;
+  return batch_;
+}
+
+void StatusBatcher::Clear() {
+  batch_.num_samples = 0;
+  batch_.sample_utime.clear();
+  batch_.acquisition_utime.clear();
+  batch_.actual_position_mm.clear();
+  batch_.actual_speed_mm_per_s.clear();
+  batch_.actual_force.clear();
+  batch_.system_state.clear();
+  batch_.grasping_state.clear();
+}
+
+}  // namespace schunk_driver
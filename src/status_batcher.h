@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+#include "schunk_driver/lcmt_schunk_wsg_status_batch.hpp"
+
+#include "position_force_control.h"
+
+namespace schunk_driver {
+
+/// Accumulates status samples into an lcmt_schunk_wsg_status_batch so that
+/// consumers who need every sample can receive them at a fraction of the
+/// per-message cost of one status message per sample.
+///
+/// A batch is ready for publication once it holds @p max_samples samples or
+/// once its oldest sample is older than @p max_latency_us, whichever comes
+/// first.
+class StatusBatcher {
+ public:
+  StatusBatcher(int max_samples, int64_t max_latency_us);
+
+  /// Appends @p sample to the pending batch.  Returns true if the batch is
+  /// now full and should be published.
+  bool Add(const StatusSample& sample);
+
+  /// Returns true if the pending batch is non-empty and its oldest sample is
+  /// older than the maximum latency as of @p now_utime.
+  bool Expired(int64_t now_utime) const;
+
+  bool empty() const { return batch_.num_samples == 0; }
+
+  /// Stamps the pending batch with @p now_utime and returns it for
+  /// publication.  The batch remains pending until Clear() is called.
+  const lcmt_schunk_wsg_status_batch& Seal(int64_t now_utime);
+
+  /// Discards the pending batch without releasing its storage.
+  void Clear();
+
+ private:
+  const int max_samples_;
+  const int64_t max_latency_us_;
+  lcmt_schunk_wsg_status_batch batch_{};
+};
+
+}  // namespace schunk_driver
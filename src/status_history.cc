@@ -0,0 +1,154 @@
+#include "status_history.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "position_force_control.h"
+
+namespace schunk_driver {
+
+namespace {
+
+int RoundUpToPowerOfTwo(int value) {
+  int result = 1;
+  while (result < value) { result <<= 1; }
+  return result;
+}
+
+// Independent accumulators per quantity in Accumulate().
+const int kLanes = 4;
+
+// Accumulates min/max/sum over one contiguous span.  The compiler may not
+// reorder a floating-point reduction itself, so the span is split across
+// kLanes accumulators, which breaks the single dependency chain through
+// each of min, max and sum.
+void Accumulate(const double* data, int count,
+                double* min, double* max, double* sum) {
+  double lane_min[kLanes];
+  double lane_max[kLanes];
+  double lane_sum[kLanes];
+  for (int lane = 0; lane < kLanes; lane++) {
+    lane_min[lane] = *min;
+    lane_max[lane] = *max;
+    lane_sum[lane] = 0;
+  }
+  int i = 0;
+  for (; i + kLanes <= count; i += kLanes) {
+    for (int lane = 0; lane < kLanes; lane++) {
+      lane_min[lane] = std::min(lane_min[lane], data[i + lane]);
+      lane_max[lane] = std::max(lane_max[lane], data[i + lane]);
+      lane_sum[lane] += data[i + lane];
+    }
+  }
+  for (; i < count; i++) {
+    lane_min[0] = std::min(lane_min[0], data[i]);
+    lane_max[0] = std::max(lane_max[0], data[i]);
+    lane_sum[0] += data[i];
+  }
+  for (int lane = 0; lane < kLanes; lane++) {
+    *min = std::min(*min, lane_min[lane]);
+    *max = std::max(*max, lane_max[lane]);
+    *sum += lane_sum[lane];
+  }
+}
+
+}  // namespace
+
+StatusHistory::StatusHistory(int capacity)
+    : mask_(RoundUpToPowerOfTwo(capacity) - 1),
+      utime_(mask_ + 1),
+      position_mm_(mask_ + 1),
+      speed_mm_per_s_(mask_ + 1),
+      force_(mask_ + 1),
+      system_state_(mask_ + 1),
+      grasping_state_(mask_ + 1) {
+  assert(capacity > 0);
+}
+
+void StatusHistory::Record(const StatusSample& sample) {
+  utime_[head_] = sample.monotonic_utime;
+  position_mm_[head_] = sample.position_mm;
+  speed_mm_per_s_[head_] = sample.speed_mm_per_s;
+  force_[head_] = sample.force;
+  system_state_[head_] = sample.system_state;
+  grasping_state_[head_] = static_cast<uint8_t>(sample.grasping_state);
+  head_ = (head_ + 1) & mask_;
+  size_ = std::min(size_ + 1, capacity());
+  total_recorded_++;
+}
+
+void StatusHistory::Clear() {
+  head_ = 0;
+  size_ = 0;
+}
+
+StatusHistory::Window StatusHistory::Between(
+    int64_t start_utime, int64_t end_utime) const {
+  Window result;
+  result.begin = LowerBound(start_utime);
+  const int end = LowerBound(end_utime + 1);
+  result.count = std::max(0, end - result.begin);
+  return result;
+}
+
+StatusHistory::Window StatusHistory::Latest(int64_t duration_us) const {
+  if (empty()) { return Window(); }
+  const int64_t newest = utime(size_ - 1);
+  return Between(newest - duration_us, newest);
+}
+
+StatusHistory::Stats StatusHistory::Summarize(
+    Field field, const Window& window) const {
+  Stats result;
+  if (window.count <= 0) { return result; }
+  assert(window.begin >= 0 && window.begin + window.count <= size_);
+  const double* column = Column(field);
+  double min = column[Physical(window.begin)];
+  double max = min;
+  double sum = 0;
+  // The window occupies at most two contiguous spans of the ring.
+  const int first = Physical(window.begin);
+  const int first_count = std::min(window.count, capacity() - first);
+  Accumulate(column + first, first_count, &min, &max, &sum);
+  Accumulate(column, window.count - first_count, &min, &max, &sum);
+  result.count = window.count;
+  result.min = min;
+  result.max = max;
+  result.mean = sum / window.count;
+  return result;
+}
+
+double StatusHistory::Rate(Field field, const Window& window) const {
+  if (window.count < 2) { return 0; }
+  const int first = window.begin;
+  const int last = window.begin + window.count - 1;
+  const int64_t dt_us = utime(last) - utime(first);
+  if (dt_us <= 0) { return 0; }
+  return (value(field, last) - value(field, first)) * 1e6 / dt_us;
+}
+
+const double* StatusHistory::Column(Field field) const {
+  switch (field) {
+    case kPositionMm: return position_mm_.data();
+    case kSpeedMmPerS: return speed_mm_per_s_.data();
+    case kForce: return force_.data();
+  }
+  assert(false);
+  return nullptr;
+}
+
+int StatusHistory::LowerBound(int64_t target_utime) const {
+  int low = 0;
+  int high = size_;
+  while (low < high) {
+    const int mid = low + (high - low) / 2;
+    if (utime(mid) < target_utime) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+}  // namespace schunk_driver
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "wsg_return_message.h"
+
+namespace schunk_driver {
+
+struct StatusSample;
+
+/// A fixed-capacity record of the most recent status samples, stored as a
+/// ring of parallel arrays (one per quantity) so that reductions over a
+/// quantity walk contiguous memory.  Recording never allocates; once full,
+/// the oldest sample is overwritten.
+///
+/// Samples are addressed by logical index, where 0 is the oldest retained
+/// sample and size() - 1 the newest.  Samples are keyed by their
+/// monotonic_utime, since the wall clock may step backwards, and are assumed
+/// to be recorded in nondecreasing order of it.
+class StatusHistory {
+ public:
+  /// Scalar quantities that may be queried.
+  enum Field { kPositionMm, kSpeedMmPerS, kForce };
+
+  /// A contiguous range of logical indices, [begin, begin + count).
+  struct Window {
+    int begin {0};
+    int count {0};
+  };
+
+  /// Summary statistics over a Window.  All are zero if count is zero.
+  struct Stats {
+    int count {0};
+    double min {0};
+    double max {0};
+    double mean {0};
+  };
+
+  /// Creates an empty history; @p capacity is rounded up to a power of two.
+  explicit StatusHistory(int capacity);
+
+  void Record(const StatusSample& sample);
+  void Clear();
+
+  int size() const { return size_; }
+  int capacity() const { return static_cast<int>(utime_.size()); }
+  bool empty() const { return size_ == 0; }
+
+  /// Total number of samples ever recorded, including those overwritten.
+  /// Useful as a cursor for consumers that drain new samples incrementally.
+  uint64_t total_recorded() const { return total_recorded_; }
+
+  /// Accessors for the sample at logical index @p i; utime() is its
+  /// monotonic_utime.
+  int64_t utime(int i) const { return utime_[Physical(i)]; }
+  double value(Field field, int i) const { return Column(field)[Physical(i)]; }
+  uint32_t system_state(int i) const { return system_state_[Physical(i)]; }
+  GraspingState grasping_state(int i) const {
+    return static_cast<GraspingState>(grasping_state_[Physical(i)]);
+  }
+
+  /// Returns the samples whose monotonic time lies in
+  /// [start_utime, end_utime].
+  Window Between(int64_t start_utime, int64_t end_utime) const;
+
+  /// Returns the samples received within @p duration_us of the newest one.
+  Window Latest(int64_t duration_us) const;
+
+  /// Computes min/max/mean of @p field over @p window.
+  Stats Summarize(Field field, const Window& window) const;
+
+  /// Returns the finite-difference rate of change of @p field per second
+  /// between the first and last samples of @p window, or zero if the window
+  /// spans no time.
+  double Rate(Field field, const Window& window) const;
+
+ private:
+  int Physical(int i) const {
+    return (head_ + capacity() - size_ + i) & mask_;
+  }
+  const double* Column(Field field) const;
+
+  // Index of the first sample at or after @p utime (binary search).
+  int LowerBound(int64_t utime) const;
+
+  const int mask_;
+  std::vector<int64_t> utime_;
+  std::vector<double> position_mm_;
+  std::vector<double> speed_mm_per_s_;
+  std::vector<double> force_;
+  std::vector<uint32_t> system_state_;
+  std::vector<uint8_t> grasping_state_;
+  int head_ {0};  //< Physical index at which the next sample is written.
+  int size_ {0};
+  uint64_t total_recorded_ {0};
+};
+
+}  // namespace schunk_driver
@@ -0,0 +1,120 @@
+#include "contact_detector.h"
+
+#include <gtest/gtest.h>
+
+namespace schunk_driver {
+namespace {
+
+// Feeds samples to a ContactDetector as the driver does, recording each
+// into the history first.
+class ContactDetectorHarness {
+ public:
+  ContactDetectorHarness() : detector_(ContactDetectorParams()) {}
+
+  // Feeds a force sample at @p monotonic_ms; returns whether an event
+  // occurred.
+  bool Force(int64_t monotonic_ms, double position_mm, double force) {
+    StatusSample sample;
+    sample.monotonic_utime = monotonic_ms * 1000;
+    sample.receive_utime = monotonic_ms * 1000 + 7;
+    sample.command = kGetForce;
+    sample.position_mm = position_mm;
+    sample.force = force;
+    return Feed(sample);
+  }
+
+  // Feeds a grasping state sample at @p monotonic_ms.
+  bool State(int64_t monotonic_ms, GraspingState grasping_state) {
+    StatusSample sample;
+    sample.monotonic_utime = monotonic_ms * 1000;
+    sample.command = kGetGraspState;
+    sample.grasping_state = grasping_state;
+    return Feed(sample);
+  }
+
+  const ContactDetector& detector() const { return detector_; }
+  const ContactEvent& event() const { return event_; }
+
+ private:
+  bool Feed(const StatusSample& sample) {
+    history_.Record(sample);
+    return detector_.Update(sample, history_, &event_);
+  }
+
+  StatusHistory history_{64};
+  ContactDetector detector_;
+  ContactEvent event_;
+};
+
+GTEST_TEST(ContactDetectorTest, ContactHysteresis) {
+  ContactDetectorHarness harness;
+  EXPECT_FALSE(harness.Force(1000, 30, 4));
+  EXPECT_FALSE(harness.detector().in_contact());
+
+  ASSERT_TRUE(harness.Force(1010, 20, 5));
+  EXPECT_EQ(harness.event().type, ContactEvent::kContact);
+  EXPECT_EQ(harness.event().sample_utime, 1010007);
+  EXPECT_EQ(harness.event().position_mm, 20);
+  EXPECT_TRUE(harness.detector().in_contact());
+
+  // Between the release and contact forces, contact persists.
+  EXPECT_FALSE(harness.Force(1200, 20, 3));
+  EXPECT_TRUE(harness.detector().in_contact());
+
+  // Releasing while opening is no event.
+  EXPECT_FALSE(harness.Force(1400, 25, 1));
+  EXPECT_FALSE(harness.detector().in_contact());
+  EXPECT_FALSE(harness.Force(1600, 25, 3));
+  EXPECT_FALSE(harness.detector().in_contact());
+}
+
+GTEST_TEST(ContactDetectorTest, LosesPartWhenClosingPastContact) {
+  ContactDetectorHarness harness;
+  ASSERT_TRUE(harness.Force(1000, 20, 10));
+  // Less than slip_width_change_mm inside the contact point.
+  EXPECT_FALSE(harness.Force(1500, 19.5, 1));
+  EXPECT_FALSE(harness.detector().in_contact());
+
+  ASSERT_TRUE(harness.Force(2000, 20, 10));
+  ASSERT_TRUE(harness.Force(2500, 18, 1));
+  EXPECT_EQ(harness.event().type, ContactEvent::kPartLost);
+  EXPECT_FALSE(harness.detector().in_contact());
+}
+
+GTEST_TEST(ContactDetectorTest, ReportsSlipOncePerWindow) {
+  ContactDetectorHarness harness;
+  ASSERT_TRUE(harness.Force(1000, 20, 10));
+  // Force falls but the fingers hold still.
+  EXPECT_FALSE(harness.Force(1010, 20, 6));
+  ASSERT_TRUE(harness.Force(1020, 18.5, 6));
+  EXPECT_EQ(harness.event().type, ContactEvent::kSlip);
+  EXPECT_DOUBLE_EQ(harness.event().force_drop, 4);
+  EXPECT_DOUBLE_EQ(harness.event().width_change_mm, 1.5);
+  EXPECT_TRUE(harness.detector().in_contact());
+
+  // The same slip is not reported again within the window...
+  EXPECT_FALSE(harness.Force(1030, 17, 5));
+  EXPECT_FALSE(harness.Force(1110, 17, 9));
+  // ...but a new one after it is.
+  EXPECT_FALSE(harness.Force(1125, 17, 9));
+  ASSERT_TRUE(harness.Force(1130, 15.5, 5));
+  EXPECT_EQ(harness.event().type, ContactEvent::kSlip);
+  EXPECT_DOUBLE_EQ(harness.event().force_drop, 4);
+}
+
+GTEST_TEST(ContactDetectorTest, FollowsGraspingState) {
+  ContactDetectorHarness harness;
+  ASSERT_TRUE(harness.State(1000, kHolding));
+  EXPECT_EQ(harness.event().type, ContactEvent::kContact);
+  EXPECT_TRUE(harness.detector().in_contact());
+  // Only changes of state are events.
+  EXPECT_FALSE(harness.State(1010, kHolding));
+
+  ASSERT_TRUE(harness.State(1020, kPartLost));
+  EXPECT_EQ(harness.event().type, ContactEvent::kPartLost);
+  EXPECT_EQ(harness.event().grasping_state, kPartLost);
+  EXPECT_FALSE(harness.detector().in_contact());
+}
+
+}  // namespace
+}  // namespace schunk_driver
@@ -0,0 +1,124 @@
+#include "grasp_episodes.h"
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "wsg_return_message.h"
+
+namespace schunk_driver {
+namespace {
+
+const int kUnknown = -1;
+
+GTEST_TEST(GraspEpisodesTest, SegmentsEpisodes) {
+  GraspEpisodeSegmenter segmenter{GraspEpisodeParams()};
+  // Without a width to compare it with, a command starts nothing.
+  segmenter.HandleCommand(0, 10, 20);
+  segmenter.HandleStatus(50, 50, 0, kUnknown);
+  segmenter.HandleCommand(100, 10, 20);
+  segmenter.HandleStatus(200, 30, 1, kUnknown);
+  segmenter.HandleStatus(300, 20, 6, kUnknown);
+  segmenter.HandleStatus(400, 20, 8, kUnknown);
+  segmenter.HandleStatus(500, 20, 10, kUnknown);
+  // Above the release force, so still in contact.
+  segmenter.HandleStatus(600, 20, 4, kUnknown);
+  segmenter.HandleSlip(650);
+  segmenter.HandleStatus(700, 20, 12, kUnknown);
+  segmenter.HandleCommand(750, 10, 25);
+  segmenter.HandleCommand(800, 60, 25);
+
+  segmenter.HandleStatus(850, 60, 0, kUnknown);
+  segmenter.HandleCommand(900, 10, 20);
+  segmenter.HandleStatus(1000, 20, 6, kUnknown);
+  segmenter.HandleStatus(1100, 25, 1, kUnknown);
+
+  const std::vector<GraspEpisode>& episodes = segmenter.Finish();
+  ASSERT_EQ(episodes.size(), 2);
+
+  const GraspEpisode& first = episodes[0];
+  EXPECT_EQ(first.start_utime, 100);
+  EXPECT_EQ(first.end_utime, 800);
+  EXPECT_TRUE(first.complete);
+  EXPECT_EQ(first.cycle_us, 800);
+  EXPECT_EQ(first.target_mm, 10);
+  EXPECT_EQ(first.commanded_force, 25);
+  EXPECT_EQ(first.contact_utime, 300);
+  EXPECT_EQ(first.contact_width_mm, 20);
+  EXPECT_TRUE(first.held);
+  EXPECT_FALSE(first.part_lost);
+  EXPECT_FALSE(first.no_part_found);
+  EXPECT_EQ(first.slips, 1);
+  EXPECT_EQ(first.force_samples, 5);
+  EXPECT_DOUBLE_EQ(first.force_mean, 8);
+  EXPECT_DOUBLE_EQ(first.force_stddev, std::sqrt(8.));
+  EXPECT_EQ(first.force_min, 4);
+  EXPECT_EQ(first.force_max, 12);
+
+  const GraspEpisode& second = episodes[1];
+  EXPECT_EQ(second.start_utime, 900);
+  EXPECT_EQ(second.end_utime, 1100);
+  EXPECT_FALSE(second.complete);
+  EXPECT_EQ(second.cycle_us, 0);
+  EXPECT_EQ(second.contact_utime, 1000);
+  EXPECT_FALSE(second.held);
+  EXPECT_TRUE(second.part_lost);
+  EXPECT_EQ(second.force_samples, 1);
+  EXPECT_EQ(second.force_stddev, 0);
+}
+
+GTEST_TEST(GraspEpisodesTest, UsesGraspingState) {
+  GraspEpisodeSegmenter segmenter{GraspEpisodeParams()};
+  segmenter.HandleStatus(0, 50, 0, kIdle);
+  segmenter.HandleCommand(100, 10, 20);
+  segmenter.HandleStatus(200, 10, 0, kNoPartFound);
+  segmenter.HandleCommand(300, 60, 20);
+  segmenter.HandleStatus(400, 60, 0, kIdle);
+  segmenter.HandleCommand(500, 10, 20);
+  // Holding with little force is still contact.
+  segmenter.HandleStatus(600, 20, 1, kHolding);
+  segmenter.HandlePartLost(650);
+  segmenter.HandleCommand(700, 60, 20);
+
+  const std::vector<GraspEpisode>& episodes = segmenter.Finish();
+  ASSERT_EQ(episodes.size(), 2);
+  EXPECT_TRUE(episodes[0].no_part_found);
+  EXPECT_EQ(episodes[0].contact_utime, 0);
+  EXPECT_FALSE(episodes[0].held);
+  EXPECT_EQ(episodes[0].force_samples, 0);
+  EXPECT_EQ(episodes[1].contact_utime, 600);
+  EXPECT_TRUE(episodes[1].held);
+  EXPECT_TRUE(episodes[1].part_lost);
+}
+
+GTEST_TEST(GraspEpisodesTest, ForceStatisticsOfManySamples) {
+  GraspEpisodeSegmenter segmenter{GraspEpisodeParams()};
+  segmenter.HandleStatus(0, 50, 0, kUnknown);
+  segmenter.HandleCommand(1, 10, 20);
+  // A count that is not a multiple of the accumulator lanes, with the
+  // extremes in the remainder.
+  const int kSamples = 103;
+  double sum = 0;
+  for (int i = 0; i < kSamples; i++) {
+    const double force = (i == 101) ? 50 : (i == 102) ? 6 : 10 + i % 7;
+    segmenter.HandleStatus(10 + i, 20, force, kUnknown);
+    sum += force;
+  }
+  const double mean = sum / kSamples;
+  double squares = 0;
+  for (int i = 0; i < kSamples; i++) {
+    const double force = (i == 101) ? 50 : (i == 102) ? 6 : 10 + i % 7;
+    squares += (force - mean) * (force - mean);
+  }
+
+  const std::vector<GraspEpisode>& episodes = segmenter.Finish();
+  ASSERT_EQ(episodes.size(), 1);
+  EXPECT_EQ(episodes[0].force_samples, kSamples);
+  EXPECT_NEAR(episodes[0].force_mean, mean, 1e-12);
+  EXPECT_NEAR(episodes[0].force_stddev, std::sqrt(squares / kSamples), 1e-12);
+  EXPECT_EQ(episodes[0].force_min, 6);
+  EXPECT_EQ(episodes[0].force_max, 50);
+}
+
+}  // namespace
+}  // namespace schunk_driver
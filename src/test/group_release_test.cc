@@ -0,0 +1,67 @@
+#include "group_release.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace schunk_driver {
+namespace {
+
+GroupRelease MakeRelease(int64_t group_id, const std::string& gripper,
+                         int num_grippers, int64_t send_ns) {
+  GroupRelease release;
+  release.group_id = group_id;
+  release.gripper = gripper;
+  release.num_grippers = num_grippers;
+  release.release_ns = 1000;
+  release.send_ns = send_ns;
+  return release;
+}
+
+GTEST_TEST(GroupSkewTrackerTest, CompletesWhenEveryGripperReports) {
+  GroupSkewTracker tracker;
+  GroupSkew skew;
+  EXPECT_FALSE(tracker.Add(MakeRelease(1, "a", 3, 1040), &skew));
+  EXPECT_FALSE(tracker.Add(MakeRelease(1, "b", 3, 1010), &skew));
+  ASSERT_TRUE(tracker.Add(MakeRelease(1, "c", 3, 1025), &skew));
+  EXPECT_EQ(skew.num_grippers, 3);
+  EXPECT_EQ(skew.skew_ns, 30);
+  EXPECT_EQ(skew.max_lateness_ns, 40);
+}
+
+GTEST_TEST(GroupSkewTrackerTest, IgnoresRepeatedReports) {
+  GroupSkewTracker tracker;
+  GroupSkew skew;
+  EXPECT_FALSE(tracker.Add(MakeRelease(1, "a", 2, 1005), &skew));
+  // Eg our own report, once directly and once back over LCM.
+  EXPECT_FALSE(tracker.Add(MakeRelease(1, "a", 2, 1900), &skew));
+  ASSERT_TRUE(tracker.Add(MakeRelease(1, "b", 2, 1015), &skew));
+  EXPECT_EQ(skew.skew_ns, 10);
+  // Once complete, further reports of the group change nothing.
+  EXPECT_FALSE(tracker.Add(MakeRelease(1, "b", 2, 1015), &skew));
+  EXPECT_FALSE(tracker.Add(MakeRelease(1, "c", 2, 2000), &skew));
+}
+
+GTEST_TEST(GroupSkewTrackerTest, NewGroupForgetsIncompleteOne) {
+  GroupSkewTracker tracker;
+  GroupSkew skew;
+  EXPECT_FALSE(tracker.Add(MakeRelease(1, "a", 2, 1005), &skew));
+  EXPECT_FALSE(tracker.Add(MakeRelease(2, "b", 2, 1100), &skew));
+  // Group 1's report from "a" no longer counts.
+  ASSERT_TRUE(tracker.Add(MakeRelease(2, "a", 2, 1120), &skew));
+  EXPECT_EQ(skew.num_grippers, 2);
+  EXPECT_EQ(skew.skew_ns, 20);
+  EXPECT_EQ(skew.max_lateness_ns, 120);
+}
+
+GTEST_TEST(GroupSkewTrackerTest, SingleGripperGroup) {
+  GroupSkewTracker tracker;
+  GroupSkew skew;
+  ASSERT_TRUE(tracker.Add(MakeRelease(7, "a", 1, 990), &skew));
+  EXPECT_EQ(skew.num_grippers, 1);
+  EXPECT_EQ(skew.skew_ns, 0);
+  EXPECT_EQ(skew.max_lateness_ns, -10);
+}
+
+}  // namespace
+}  // namespace schunk_driver
@@ -0,0 +1,144 @@
+#include "lcm_log_reader.h"
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+namespace schunk_driver {
+namespace {
+
+typedef std::vector<unsigned char> Bytes;
+
+void AppendBigEndian(uint64_t value, int size, Bytes* log) {
+  for (int i = size - 1; i >= 0; i--) {
+    log->push_back((value >> (8 * i)) & 0xff);
+  }
+}
+
+// Appends an event as lcm-logger writes it, claiming @p data_size bytes of
+// data however many follow.
+void AppendEvent(int64_t event_number, const std::string& channel,
+                 const std::string& data, Bytes* log,
+                 int32_t data_size = -1) {
+  AppendBigEndian(0xEDA1DA01, 4, log);
+  AppendBigEndian(event_number, 8, log);
+  AppendBigEndian(1000 * event_number, 8, log);
+  AppendBigEndian(channel.size(), 4, log);
+  AppendBigEndian(data_size < 0 ? data.size() : data_size, 4, log);
+  log->insert(log->end(), channel.begin(), channel.end());
+  log->insert(log->end(), data.begin(), data.end());
+}
+
+// A log file that is removed when it goes out of scope.
+class TempLog {
+ public:
+  explicit TempLog(const Bytes& log) {
+    char path[] = "/tmp/lcm_log_reader_testXXXXXX";
+    const int fd = mkstemp(path);
+    EXPECT_GE(fd, 0);
+    EXPECT_EQ(write(fd, log.data(), log.size()),
+              static_cast<ssize_t>(log.size()));
+    close(fd);
+    path_ = path;
+  }
+
+  ~TempLog() { unlink(path_.c_str()); }
+
+  const std::string& path() const { return path_; }
+
+ private:
+  std::string path_;
+};
+
+// The event numbers of every event in the log at @p path.
+std::vector<int64_t> ReadEventNumbers(const std::string& path,
+                                      size_t* bytes_skipped = nullptr) {
+  LcmLogReader reader(path);
+  std::vector<int64_t> result;
+  LcmLogEvent event;
+  while (reader.Next(&event)) {
+    result.push_back(event.event_number);
+  }
+  if (bytes_skipped) { *bytes_skipped = reader.bytes_skipped(); }
+  return result;
+}
+
+GTEST_TEST(LcmLogReaderTest, ReadsEvents) {
+  Bytes log;
+  AppendEvent(0, "STATUS", "abc", &log);
+  AppendEvent(1, "COMMAND", "", &log);
+  TempLog file(log);
+
+  LcmLogReader reader(file.path());
+  EXPECT_EQ(reader.size(), log.size());
+  LcmLogEvent event;
+  ASSERT_TRUE(reader.Next(&event));
+  EXPECT_EQ(event.event_number, 0);
+  EXPECT_EQ(event.utime, 0);
+  EXPECT_TRUE(LcmLogReader::OnChannel(event, "STATUS"));
+  EXPECT_FALSE(LcmLogReader::OnChannel(event, "STATUS2"));
+  ASSERT_EQ(event.data_size, 3);
+  EXPECT_EQ(std::string(static_cast<const char*>(event.data), 3), "abc");
+  ASSERT_TRUE(reader.Next(&event));
+  EXPECT_EQ(event.event_number, 1);
+  EXPECT_EQ(event.utime, 1000);
+  EXPECT_TRUE(LcmLogReader::OnChannel(event, "COMMAND"));
+  EXPECT_EQ(event.data_size, 0);
+  EXPECT_FALSE(reader.Next(&event));
+  EXPECT_FALSE(reader.Next(&event));
+  EXPECT_EQ(reader.bytes_skipped(), 0);
+}
+
+GTEST_TEST(LcmLogReaderTest, EmptyLog) {
+  TempLog file(Bytes{});
+  EXPECT_TRUE(ReadEventNumbers(file.path()).empty());
+}
+
+GTEST_TEST(LcmLogReaderTest, MissingLogThrows) {
+  EXPECT_THROW(LcmLogReader("/nonexistent/log"), std::runtime_error);
+}
+
+GTEST_TEST(LcmLogReaderTest, EndsAtTruncatedLastEvent) {
+  Bytes log;
+  AppendEvent(0, "STATUS", "abc", &log);
+  AppendEvent(1, "STATUS", "abcdef", &log);
+  log.resize(log.size() - 2);
+  TempLog file(log);
+  EXPECT_EQ(ReadEventNumbers(file.path()), std::vector<int64_t>({0}));
+}
+
+GTEST_TEST(LcmLogReaderTest, SkipsGarbage) {
+  Bytes log;
+  AppendEvent(0, "STATUS", "abc", &log);
+  log.insert(log.end(), {0xED, 0xA1, 0x00, 0x01, 0x02});
+  AppendEvent(1, "STATUS", "abc", &log);
+  TempLog file(log);
+  size_t bytes_skipped = 0;
+  EXPECT_EQ(ReadEventNumbers(file.path(), &bytes_skipped),
+            std::vector<int64_t>({0, 1}));
+  EXPECT_EQ(bytes_skipped, 5);
+}
+
+GTEST_TEST(LcmLogReaderTest, ResyncsAfterOverlongEvent) {
+  // A corrupt data size runs past the end of the log, but later events
+  // show that the log goes on.
+  Bytes log;
+  AppendEvent(0, "STATUS", "abc", &log);
+  const size_t corrupt_begin = log.size();
+  AppendEvent(1, "STATUS", "abc", &log, 1 << 20);
+  const size_t corrupt_size = log.size() - corrupt_begin;
+  AppendEvent(2, "STATUS", "abc", &log);
+  AppendEvent(3, "STATUS", "abc", &log);
+  TempLog file(log);
+  size_t bytes_skipped = 0;
+  EXPECT_EQ(ReadEventNumbers(file.path(), &bytes_skipped),
+            std::vector<int64_t>({0, 2, 3}));
+  EXPECT_EQ(bytes_skipped, corrupt_size);
+}
+
+}  // namespace
+}  // namespace schunk_driver
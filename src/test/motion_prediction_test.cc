@@ -0,0 +1,105 @@
+#include "motion_prediction.h"
+
+#include <gtest/gtest.h>
+
+namespace schunk_driver {
+namespace {
+
+const double kMaxSpeed = 100;  // mm/s
+const double kMaxAcc = 1000;  // mm/s^2
+// The prediction integrates in 1 ms steps, so phase changes land up to a
+// step late.
+const double kPositionTolerance = 0.2;
+const double kSpeedTolerance = 1.5;
+
+FingerMotion Motion(double position_mm, double speed_mm_per_s) {
+  FingerMotion motion;
+  motion.position_mm = position_mm;
+  motion.speed_mm_per_s = speed_mm_per_s;
+  return motion;
+}
+
+FingerMotion Predict(const FingerMotion& start, double target_mm,
+                     double duration_s) {
+  return PredictFingerMotion(start, target_mm, duration_s,
+                             kMaxSpeed, kMaxAcc);
+}
+
+// From rest at 0 to 100: accelerating for 0.1 s over 5 mm, cruising at
+// 100 mm/s for 0.9 s to 95 mm, then decelerating for 0.1 s onto 100 mm.
+GTEST_TEST(MotionPredictionTest, TrapezoidalProfile) {
+  const FingerMotion start = Motion(0, 0);
+  struct Expected { double t, position_mm, speed_mm_per_s; };
+  const Expected expected[] = {
+    {0.05, 1.25, 50},  // Accelerating.
+    {0.1, 5, 100},
+    {0.5, 45, 100},  // Cruising.
+    {1.0, 95, 100},
+    {1.05, 98.75, 50},  // Decelerating.
+    {1.2, 100, 0},  // Stopped on the target.
+    {5.0, 100, 0},
+  };
+  for (const Expected& e : expected) {
+    const FingerMotion motion = Predict(start, 100, e.t);
+    EXPECT_NEAR(motion.position_mm, e.position_mm, kPositionTolerance)
+        << "t = " << e.t;
+    EXPECT_NEAR(motion.speed_mm_per_s, e.speed_mm_per_s, kSpeedTolerance)
+        << "t = " << e.t;
+  }
+}
+
+GTEST_TEST(MotionPredictionTest, ClosingIsSymmetric) {
+  const FingerMotion motion = Predict(Motion(100, 0), 0, 0.5);
+  EXPECT_NEAR(motion.position_mm, 55, kPositionTolerance);
+  EXPECT_NEAR(motion.speed_mm_per_s, -100, kSpeedTolerance);
+}
+
+GTEST_TEST(MotionPredictionTest, SpeedIsCapped) {
+  // Already faster than the cap, far from the target.
+  const FingerMotion motion = Predict(Motion(0, 150), 100, 0.3);
+  EXPECT_EQ(motion.speed_mm_per_s, kMaxSpeed);
+  EXPECT_NEAR(motion.position_mm, 30, kPositionTolerance);
+}
+
+GTEST_TEST(MotionPredictionTest, OvershootsAndReturns) {
+  // Stopping from 100 mm/s takes 5 mm, more than the 2 mm to go.
+  const FingerMotion start = Motion(0, 100);
+  FingerMotion motion = Predict(start, 2, 0.1);
+  EXPECT_NEAR(motion.position_mm, 5, kPositionTolerance);
+  EXPECT_NEAR(motion.speed_mm_per_s, 0, kSpeedTolerance);
+  motion = Predict(start, 2, 0.15);
+  EXPECT_LT(motion.speed_mm_per_s, 0);
+  EXPECT_LT(motion.position_mm, 5);
+  motion = Predict(start, 2, 1);
+  EXPECT_EQ(motion.position_mm, 2);
+  EXPECT_EQ(motion.speed_mm_per_s, 0);
+}
+
+GTEST_TEST(MotionPredictionTest, ReversesWhenMovingAway) {
+  // Opening at full speed with the target behind: 0.1 s and 5 mm to stop.
+  const FingerMotion start = Motion(50, 100);
+  FingerMotion motion = Predict(start, 40, 0.1);
+  EXPECT_NEAR(motion.position_mm, 55, kPositionTolerance);
+  EXPECT_NEAR(motion.speed_mm_per_s, 0, kSpeedTolerance);
+  motion = Predict(start, 40, 0.2);
+  EXPECT_NEAR(motion.position_mm, 50, kPositionTolerance);
+  EXPECT_NEAR(motion.speed_mm_per_s, -100, kSpeedTolerance);
+  motion = Predict(start, 40, 1);
+  EXPECT_EQ(motion.position_mm, 40);
+  EXPECT_EQ(motion.speed_mm_per_s, 0);
+}
+
+GTEST_TEST(MotionPredictionTest, NoDurationOrLimitsPredictsNoMotion) {
+  const FingerMotion start = Motion(20, 30);
+  for (double duration_s : {0.0, -0.5}) {
+    const FingerMotion motion = Predict(start, 80, duration_s);
+    EXPECT_EQ(motion.position_mm, 20);
+    EXPECT_EQ(motion.speed_mm_per_s, 30);
+  }
+  const FingerMotion motion = PredictFingerMotion(start, 80, 1, 0, kMaxAcc);
+  EXPECT_EQ(motion.position_mm, 20);
+  EXPECT_EQ(motion.speed_mm_per_s, 30);
+}
+
+}  // namespace
+}  // namespace schunk_driver
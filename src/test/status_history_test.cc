@@ -0,0 +1,92 @@
+#include "status_history.h"
+
+#include <gtest/gtest.h>
+
+#include "position_force_control.h"
+
+namespace schunk_driver {
+namespace {
+
+StatusSample MakeSample(int64_t monotonic_utime, double force) {
+  StatusSample sample;
+  sample.monotonic_utime = monotonic_utime;
+  // The wall clock is deliberately out of order; it must not be consulted.
+  sample.receive_utime = -monotonic_utime;
+  sample.position_mm = force / 2;
+  sample.force = force;
+  return sample;
+}
+
+GTEST_TEST(StatusHistoryTest, RoundsCapacityUp) {
+  StatusHistory history(5);
+  EXPECT_EQ(history.capacity(), 8);
+  EXPECT_TRUE(history.empty());
+  EXPECT_EQ(history.Latest(1000).count, 0);
+  EXPECT_EQ(history.Summarize(StatusHistory::kForce,
+                              history.Latest(1000)).count, 0);
+}
+
+GTEST_TEST(StatusHistoryTest, KeysOnMonotonicTime) {
+  StatusHistory history(16);
+  for (int i = 0; i < 10; i++) {
+    history.Record(MakeSample(1000 * i, i));
+  }
+  ASSERT_EQ(history.size(), 10);
+  EXPECT_EQ(history.utime(0), 0);
+  EXPECT_EQ(history.utime(9), 9000);
+
+  const StatusHistory::Window between = history.Between(2000, 4500);
+  EXPECT_EQ(between.begin, 2);
+  EXPECT_EQ(between.count, 3);
+
+  const StatusHistory::Window latest = history.Latest(3000);
+  EXPECT_EQ(latest.begin, 6);
+  EXPECT_EQ(latest.count, 4);
+
+  EXPECT_EQ(history.Between(20000, 30000).count, 0);
+}
+
+GTEST_TEST(StatusHistoryTest, SummarizesAcrossWrap) {
+  StatusHistory history(8);
+  // Thirteen samples into eight slots leaves the window split across the
+  // end of the ring; the odd lengths exercise the accumulator tails.
+  const double forces[] = {9, 9, 9, 9, 9, 4, -3, 7, 1, 8, 2, 6, 5};
+  for (int i = 0; i < 13; i++) {
+    history.Record(MakeSample(100 * i, forces[i]));
+  }
+  EXPECT_EQ(history.size(), 8);
+  EXPECT_EQ(history.total_recorded(), 13u);
+  EXPECT_EQ(history.utime(0), 500);
+
+  const StatusHistory::Stats all = history.Summarize(
+      StatusHistory::kForce, history.Latest(10000));
+  EXPECT_EQ(all.count, 8);
+  EXPECT_EQ(all.min, -3);
+  EXPECT_EQ(all.max, 8);
+  EXPECT_DOUBLE_EQ(all.mean, 30.0 / 8);
+
+  const StatusHistory::Stats tail = history.Summarize(
+      StatusHistory::kForce, history.Between(900, 1100));
+  EXPECT_EQ(tail.count, 3);
+  EXPECT_EQ(tail.min, 2);
+  EXPECT_EQ(tail.max, 8);
+  EXPECT_DOUBLE_EQ(tail.mean, 16.0 / 3);
+}
+
+GTEST_TEST(StatusHistoryTest, Rate) {
+  StatusHistory history(8);
+  history.Record(MakeSample(0, 0));
+  history.Record(MakeSample(500000, 5));
+  history.Record(MakeSample(1000000, 10));
+  EXPECT_DOUBLE_EQ(
+      history.Rate(StatusHistory::kForce, history.Latest(1000000)), 10);
+  EXPECT_DOUBLE_EQ(
+      history.Rate(StatusHistory::kPositionMm, history.Latest(1000000)), 5);
+  EXPECT_EQ(history.Rate(StatusHistory::kForce, history.Latest(0)), 0);
+
+  history.Clear();
+  EXPECT_TRUE(history.empty());
+}
+
+}  // namespace
+}  // namespace schunk_driver
@@ -0,0 +1,105 @@
+#include "wsg_stream_parser.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "wsg_return_message.h"
+
+namespace schunk_driver {
+namespace {
+
+std::vector<unsigned char> MakeFrame(int command,
+                                     std::vector<unsigned char> params) {
+  std::vector<unsigned char> frame;
+  WsgReturnMessage(command, 0, params).Serialize(frame);
+  return frame;
+}
+
+void Append(WsgStreamParser* parser, const std::vector<unsigned char>& bytes) {
+  ASSERT_EQ(parser->Append(bytes.data(), bytes.size()), bytes.size());
+}
+
+void ExpectFrame(WsgStreamParser* parser, int command,
+                 const std::vector<unsigned char>& params) {
+  WsgFrame frame;
+  ASSERT_TRUE(parser->Next(&frame));
+  EXPECT_EQ(frame.command, command);
+  EXPECT_EQ(frame.status, 0);
+  EXPECT_EQ(std::vector<unsigned char>(
+                frame.params, frame.params + frame.params_size), params);
+}
+
+GTEST_TEST(WsgStreamParserTest, SplitFrame) {
+  const std::vector<unsigned char> frame = MakeFrame(0x43, {1, 2, 3, 4});
+  WsgStreamParser parser;
+  WsgFrame out;
+  // Deliver one byte at a time, as a slow stream might.
+  for (size_t i = 0; i + 1 < frame.size(); i++) {
+    Append(&parser, {frame[i]});
+    EXPECT_FALSE(parser.Next(&out));
+  }
+  Append(&parser, {frame.back()});
+  ExpectFrame(&parser, 0x43, {1, 2, 3, 4});
+  EXPECT_FALSE(parser.Next(&out));
+  EXPECT_EQ(parser.counters().frames, 1u);
+  EXPECT_EQ(parser.counters().resyncs, 0u);
+}
+
+GTEST_TEST(WsgStreamParserTest, CoalescedFrames) {
+  std::vector<unsigned char> bytes;
+  for (int i = 0; i < 3; i++) {
+    const std::vector<unsigned char> frame =
+        MakeFrame(0x40 + i, {static_cast<unsigned char>(i)});
+    bytes.insert(bytes.end(), frame.begin(), frame.end());
+  }
+  // End with half of a fourth frame.
+  const std::vector<unsigned char> last = MakeFrame(0x50, {9, 9});
+  bytes.insert(bytes.end(), last.begin(), last.begin() + 5);
+
+  WsgStreamParser parser;
+  Append(&parser, bytes);
+  ExpectFrame(&parser, 0x40, {0});
+  ExpectFrame(&parser, 0x41, {1});
+  ExpectFrame(&parser, 0x42, {2});
+  WsgFrame out;
+  EXPECT_FALSE(parser.Next(&out));
+  Append(&parser, std::vector<unsigned char>(last.begin() + 5, last.end()));
+  ExpectFrame(&parser, 0x50, {9, 9});
+}
+
+GTEST_TEST(WsgStreamParserTest, CorruptedFrames) {
+  std::vector<unsigned char> bytes = {0x00, 0xaa, 0x17, 0xaa, 0xaa};
+  // A frame with a bad checksum.
+  std::vector<unsigned char> bad = MakeFrame(0x41, {5, 6});
+  bad.back() ^= 0xff;
+  bytes.insert(bytes.end(), bad.begin(), bad.end());
+  // A false preamble whose length field runs far past any real message.
+  const std::vector<unsigned char> long_length = {0xaa, 0xaa, 0xaa, 0x41,
+                                                  0x00, 0x80};
+  bytes.insert(bytes.end(), long_length.begin(), long_length.end());
+  const std::vector<unsigned char> good = MakeFrame(0x42, {7});
+  bytes.insert(bytes.end(), good.begin(), good.end());
+
+  WsgStreamParser parser;
+  Append(&parser, bytes);
+  ExpectFrame(&parser, 0x42, {7});
+  WsgFrame out;
+  EXPECT_FALSE(parser.Next(&out));
+  EXPECT_EQ(parser.counters().frames, 1u);
+  EXPECT_EQ(parser.counters().checksum_errors, 1u);
+  EXPECT_GE(parser.counters().bad_lengths, 1u);
+  EXPECT_EQ(parser.counters().bytes_skipped, bytes.size() - good.size());
+}
+
+GTEST_TEST(WsgStreamParserTest, Reset) {
+  const std::vector<unsigned char> frame = MakeFrame(0x43, {1});
+  WsgStreamParser parser;
+  Append(&parser, std::vector<unsigned char>(frame.begin(), frame.begin() + 4));
+  parser.Reset();
+  Append(&parser, frame);
+  ExpectFrame(&parser, 0x43, {1});
+}
+
+}  // namespace
+}  // namespace schunk_driver
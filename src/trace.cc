@@ -0,0 +1,206 @@
+#include "trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace schunk_driver {
+namespace {
+
+// Events per thread between drains.  At 64 bytes each this is 512 kB per
+// thread, enough for a busy driver thread between flushes with a wide
+// margin.
+const uint64_t kRingCapacity = 8192;
+const int kFlushPeriodMs = 50;
+
+/// A single-producer, single-consumer ring of one thread's events.
+struct ThreadBuffer {
+  explicit ThreadBuffer(int64_t thread_id) : tid(thread_id) {}
+
+  const int64_t tid;
+  std::atomic<uint64_t> head {0};  //< Written only by the owning thread.
+  std::atomic<uint64_t> tail {0};  //< Written only by the drain.
+  std::atomic<uint64_t> dropped {0};
+  TraceEvent events[kRingCapacity];
+};
+
+// Every thread's buffer.  Buffers outlive their threads, so that the drain
+// may still read them; the registry lock is taken only when a thread
+// records its first event and when draining.
+std::mutex registry_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+thread_local ThreadBuffer* thread_buffer = nullptr;
+
+// Output state, touched only by Start(), Stop() and the flush thread.
+std::ofstream output;
+bool output_empty = true;
+int64_t pid = 0;
+std::atomic<bool> flushing {false};
+std::thread flush_thread;
+
+ThreadBuffer* GetThreadBuffer() {
+  if (!thread_buffer) {
+    std::unique_ptr<ThreadBuffer> buffer(
+        new ThreadBuffer(syscall(SYS_gettid)));
+    thread_buffer = buffer.get();
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    registry.push_back(std::move(buffer));
+  }
+  return thread_buffer;
+}
+
+void WriteEvent(int64_t tid, const TraceEvent& event) {
+  output << (output_empty ? "[\n" : ",\n");
+  output_empty = false;
+  if (event.phase == 'M') {
+    output << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+           << ",\"tid\":" << tid << ",\"args\":{\"name\":\""
+           << event.name << "\"}}";
+    return;
+  }
+  // Chrome timestamps are microseconds; keep nanosecond resolution.
+  char ts[32];
+  snprintf(ts, sizeof(ts), "%.3f", event.ts_ns / 1e3);
+  output << "{\"name\":\"" << event.name << "\",\"cat\":\""
+         << event.category << "\",\"ph\":\"" << event.phase
+         << "\",\"ts\":" << ts;
+  if (event.phase == 'X') {
+    snprintf(ts, sizeof(ts), "%.3f", event.dur_ns / 1e3);
+    output << ",\"dur\":" << ts;
+  } else if (event.phase == 'i') {
+    output << ",\"s\":\"t\"";
+  }
+  output << ",\"pid\":" << pid << ",\"tid\":" << tid;
+  if (event.arg_names[0] || event.arg_names[1]) {
+    output << ",\"args\":{";
+    bool first = true;
+    for (int i = 0; i < 2; i++) {
+      if (!event.arg_names[i]) { continue; }
+      output << (first ? "" : ",") << "\"" << event.arg_names[i] << "\":"
+             << event.args[i];
+      first = false;
+    }
+    output << "}";
+  }
+  output << "}";
+}
+
+// Writes out every event recorded so far.
+void Drain() {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for (const auto& buffer : registry) {
+    const uint64_t head = buffer->head.load(std::memory_order_acquire);
+    uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+    for (; tail != head; tail++) {
+      WriteEvent(buffer->tid, buffer->events[tail % kRingCapacity]);
+    }
+    buffer->tail.store(tail, std::memory_order_release);
+  }
+  output.flush();
+}
+
+void FlushLoop() {
+  while (flushing) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(kFlushPeriodMs));
+    Drain();
+  }
+}
+
+}  // namespace
+
+std::atomic<bool> Tracer::enabled_ {false};
+
+void Tracer::Start(const std::string& path) {
+  if (enabled()) {
+    throw std::runtime_error("Tracing already started");
+  }
+  output.open(path, std::ios::out | std::ios::trunc);
+  if (!output) {
+    throw std::runtime_error("Could not open trace file " + path);
+  }
+  output_empty = true;
+  pid = getpid();
+  {
+    // Discard anything recorded after a previous Stop().
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const auto& buffer : registry) {
+      buffer->tail.store(buffer->head.load(std::memory_order_acquire),
+                         std::memory_order_release);
+      buffer->dropped = 0;
+    }
+  }
+  flushing = true;
+  flush_thread = std::thread(&FlushLoop);
+  enabled_ = true;
+}
+
+void Tracer::Stop() {
+  if (!enabled()) { return; }
+  enabled_ = false;
+  flushing = false;
+  flush_thread.join();
+  Drain();
+  uint64_t dropped = 0;
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const auto& buffer : registry) { dropped += buffer->dropped; }
+  }
+  output << (output_empty ? "[]\n" : "\n]\n");
+  output.close();
+  if (dropped) {
+    std::cerr << "Trace dropped " << dropped
+              << " events to full buffers" << std::endl;
+  }
+}
+
+int64_t Tracer::NowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+void Tracer::Record(const TraceEvent& event) {
+  if (!enabled()) { return; }
+  ThreadBuffer* buffer = GetThreadBuffer();
+  const uint64_t head = buffer->head.load(std::memory_order_relaxed);
+  if (head - buffer->tail.load(std::memory_order_acquire) >= kRingCapacity) {
+    buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  buffer->events[head % kRingCapacity] = event;
+  buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void Tracer::SetThreadName(const char* name) {
+  TraceEvent event;
+  event.name = name;
+  event.phase = 'M';
+  Record(event);
+}
+
+TraceSpan::TraceSpan(const char* category, const char* name)
+    : enabled_(Tracer::enabled()) {
+  if (!enabled_) { return; }
+  event_.category = category;
+  event_.name = name;
+  event_.phase = 'X';
+  event_.ts_ns = Tracer::NowNs();
+}
+
+TraceSpan::~TraceSpan() {
+  if (!enabled_) { return; }
+  event_.dur_ns = Tracer::NowNs() - event_.ts_ns;
+  Tracer::Record(event_);
+}
+
+}  // namespace schunk_driver
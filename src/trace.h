@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace schunk_driver {
+
+/// One trace event.  Names are not copied, so they must be string literals
+/// (or otherwise outlive the trace).
+struct TraceEvent {
+  const char* category {nullptr};
+  const char* name {nullptr};
+  char phase {0};  //< 'X' for a span, 'i' for an instant, 'M' for metadata.
+  int64_t ts_ns {0};
+  int64_t dur_ns {0};
+  // Up to two integer arguments; unused ones have a null name.
+  const char* arg_names[2] {nullptr, nullptr};
+  int64_t args[2] {0, 0};
+};
+
+/// Opt-in, process-wide event tracing, written in the Chrome trace event
+/// JSON format that chrome://tracing and ui.perfetto.dev open.
+///
+/// Each thread records into its own single-producer ring buffer, so
+/// recording never takes a lock or makes a system call; a background thread
+/// drains the rings to the file every few tens of milliseconds.  Events that
+/// find their ring full are dropped and counted.  While tracing is off,
+/// recording costs one relaxed atomic load.
+///
+/// Timestamps are CLOCK_MONOTONIC, whatever Clock the driver runs on.
+class Tracer {
+ public:
+  /// Starts tracing to @p path.  Throws std::runtime_error if it cannot be
+  /// opened.  The file is a bare JSON array, which the viewers accept even
+  /// if the process dies before Stop() closes it.
+  static void Start(const std::string& path);
+
+  /// Drains every thread's events, closes the file and stops tracing.
+  static void Stop();
+
+  static bool enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  static int64_t NowNs();
+
+  /// Records @p event for the calling thread, if tracing.
+  static void Record(const TraceEvent& event);
+
+  /// Names the calling thread in the viewers; @p name must be a literal.
+  static void SetThreadName(const char* name);
+
+ private:
+  static std::atomic<bool> enabled_;
+};
+
+/// Records a span from construction to destruction, if tracing was enabled
+/// at construction.
+class TraceSpan {
+ public:
+  TraceSpan(const char* category, const char* name);
+  ~TraceSpan();
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+  /// Attaches integer argument @p index (0 or 1) to the span.
+  void SetArg(int index, const char* name, int64_t value) {
+    event_.arg_names[index] = name;
+    event_.args[index] = value;
+  }
+
+ private:
+  TraceEvent event_;
+  const bool enabled_;
+};
+
+/// Records an instant event with up to two integer arguments.
+inline void TraceInstant(const char* category, const char* name,
+                         const char* arg0_name = nullptr, int64_t arg0 = 0,
+                         const char* arg1_name = nullptr, int64_t arg1 = 0) {
+  if (!Tracer::enabled()) { return; }
+  TraceEvent event;
+  event.category = category;
+  event.name = name;
+  event.phase = 'i';
+  event.ts_ns = Tracer::NowNs();
+  event.arg_names[0] = arg0_name;
+  event.args[0] = arg0;
+  event.arg_names[1] = arg1_name;
+  event.args[1] = arg1;
+  Tracer::Record(event);
+}
+
+}  // namespace schunk_driver
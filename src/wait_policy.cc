@@ -0,0 +1,146 @@
+#include "wait_policy.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "clock.h"
+
+namespace schunk_driver {
+
+WaitPolicy::WaitPolicy(int fd, const WaitPolicyParams& params)
+    : fd_(fd),
+      params_(params),
+      epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+      timer_fd_(timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC)) {
+  if (epoll_fd_ < 0 || timer_fd_ < 0) {
+    throw std::runtime_error(std::string("epoll setup failed: ") +
+                             strerror(errno));
+  }
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.fd = fd_;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd_, &event) != 0) {
+    throw std::runtime_error(std::string("epoll_ctl failed: ") +
+                             strerror(errno));
+  }
+  event.data.fd = timer_fd_;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &event) != 0) {
+    throw std::runtime_error(std::string("epoll_ctl failed: ") +
+                             strerror(errno));
+  }
+  if (params_.busy_poll_us > 0 &&
+      setsockopt(fd_, SOL_SOCKET, SO_BUSY_POLL, &params_.busy_poll_us,
+                 sizeof(params_.busy_poll_us)) != 0) {
+    std::cerr << "SO_BUSY_POLL unavailable: " << strerror(errno)
+              << std::endl;
+  }
+}
+
+WaitPolicy::~WaitPolicy() {
+  close(timer_fd_);
+  close(epoll_fd_);
+}
+
+void WaitPolicy::ExpectPeriodic(int stream, int64_t arrival_ns,
+                                int64_t period_ns) {
+  if (stream >= static_cast<int>(streams_.size())) {
+    streams_.resize(stream + 1);
+  }
+  streams_[stream].arrival_ns = arrival_ns;
+  streams_[stream].period_ns = period_ns;
+}
+
+void WaitPolicy::ExpectOnce(int64_t arrival_ns) {
+  once_arrival_ns_ = arrival_ns;
+}
+
+int64_t WaitPolicy::NextArrivalNs(int64_t now_ns) const {
+  // Windows close spin_after_ns after their arrival.
+  const int64_t after_ns = now_ns - params_.spin_after_ns;
+  int64_t next_ns = (once_arrival_ns_ > after_ns) ? once_arrival_ns_ : 0;
+  for (const Stream& stream : streams_) {
+    if (stream.period_ns <= 0) { continue; }
+    int64_t arrival_ns = stream.arrival_ns;
+    if (arrival_ns <= after_ns) {
+      // Skip whole periods to the first arrival still in (or before) its
+      // window.
+      arrival_ns += ((after_ns - arrival_ns) / stream.period_ns + 1) *
+          stream.period_ns;
+    }
+    if (next_ns == 0 || arrival_ns < next_ns) { next_ns = arrival_ns; }
+  }
+  return next_ns;
+}
+
+bool WaitPolicy::EpollUntil(int64_t deadline_ns) {
+  int timeout_ms = 0;
+  if (deadline_ns > 0) {
+    struct itimerspec timer;
+    memset(&timer, 0, sizeof(timer));
+    timer.it_value.tv_sec = deadline_ns / 1000000000L;
+    timer.it_value.tv_nsec = deadline_ns % 1000000000L;
+    // Rearming also clears any previous expiry.
+    timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &timer, nullptr);
+    timeout_ms = -1;
+  }
+  struct epoll_event events[2];
+  int count;
+  do {
+    count = epoll_wait(epoll_fd_, events, 2, timeout_ms);
+  } while (count < 0 && errno == EINTR);
+  for (int i = 0; i < count; i++) {
+    if (events[i].data.fd == fd_) { return true; }
+  }
+  return false;
+}
+
+bool WaitPolicy::WaitUntil(int64_t deadline_ns) {
+  Clock* clock = SystemClock::Get();
+  int64_t now_ns = clock->NowNs();
+  while (now_ns < deadline_ns) {
+    const int64_t arrival_ns = NextArrivalNs(now_ns);
+    if (arrival_ns != 0 && now_ns >= arrival_ns - params_.spin_before_ns) {
+      // Spin until the window closes.
+      const int64_t end_ns =
+          std::min(deadline_ns, arrival_ns + params_.spin_after_ns);
+      const int64_t start_ns = now_ns;
+      bool readable = false;
+      while (!readable && now_ns < end_ns) {
+        readable = EpollUntil(0);
+        now_ns = clock->NowNs();
+      }
+      stats_.spin_ns += now_ns - start_ns;
+      if (readable) {
+        stats_.spin_wakeups++;
+        return true;
+      }
+      if (arrival_ns == once_arrival_ns_) { once_arrival_ns_ = 0; }
+      continue;
+    }
+    // Block until the next window opens.
+    const int64_t end_ns = (arrival_ns == 0)
+        ? deadline_ns
+        : std::min(deadline_ns, arrival_ns - params_.spin_before_ns);
+    const int64_t start_ns = now_ns;
+    const bool readable = EpollUntil(end_ns);
+    now_ns = clock->NowNs();
+    stats_.block_ns += now_ns - start_ns;
+    if (readable) {
+      stats_.block_wakeups++;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace schunk_driver
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace schunk_driver {
+
+/// Tuning of WaitPolicy.  Spinning answers a message within microseconds of
+/// its arrival but occupies a core; blocking frees the core but adds the
+/// scheduler's wakeup latency.
+struct WaitPolicyParams {
+  /// Spin from this long before each expected arrival...
+  int64_t spin_before_ns {100000};
+  /// ...until this long after it, then block.  Arrivals are estimated from
+  /// their earliest observed times, so most messages come somewhat late.
+  int64_t spin_after_ns {400000};
+  /// The time from sending a command to its response, used to expect the
+  /// response until link probes have measured the round trip.
+  int64_t response_latency_ns {1000000};
+  /// If positive, sets SO_BUSY_POLL on the socket so that the kernel polls
+  /// the device queue for this many microseconds when the socket is read or
+  /// waited on while empty.  Raising it above net.core.busy_read requires
+  /// CAP_NET_ADMIN.
+  int busy_poll_us {0};
+};
+
+/// Waits for a socket to become readable, spinning in a bounded window
+/// around each expected arrival (of periodic status messages, or of a
+/// response just requested) and otherwise blocking in epoll_wait.  A timerfd
+/// in the same epoll set bounds each block with nanosecond precision.
+///
+/// Times are on the host's real-time clock, as are message receive stamps.
+class WaitPolicy {
+ public:
+  /// Time spent waiting in each way, and the number of waits that each
+  /// ended.
+  struct Stats {
+    int64_t spin_ns {0};
+    int64_t block_ns {0};
+    uint64_t spin_wakeups {0};
+    uint64_t block_wakeups {0};
+  };
+
+  /// Waits on @p fd, which must outlive this object.  Throws
+  /// std::runtime_error if the epoll set cannot be created.
+  WaitPolicy(int fd, const WaitPolicyParams& params);
+
+  ~WaitPolicy();
+
+  WaitPolicy(const WaitPolicy&) = delete;
+  WaitPolicy& operator=(const WaitPolicy&) = delete;
+
+  /// Expects messages of stream number @p stream every @p period_ns, one of
+  /// them at @p arrival_ns.  Replaces any previous expectation of that
+  /// stream.
+  void ExpectPeriodic(int stream, int64_t arrival_ns, int64_t period_ns);
+
+  /// Expects a single message (eg a response) at about @p arrival_ns.
+  void ExpectOnce(int64_t arrival_ns);
+
+  /// Waits until the socket is readable or @p deadline_ns passes.  Returns
+  /// true if the socket is readable.
+  bool WaitUntil(int64_t deadline_ns);
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  struct Stream {
+    int64_t arrival_ns {0};
+    int64_t period_ns {0};  //< Zero if the stream is not expected.
+  };
+
+  // The earliest expected arrival whose spin window has not yet closed at
+  // @p now_ns, or zero if none is expected.
+  int64_t NextArrivalNs(int64_t now_ns) const;
+
+  // Polls (if @p deadline_ns is zero) or blocks until the socket is
+  // readable or the deadline passes.
+  bool EpollUntil(int64_t deadline_ns);
+
+  const int fd_;
+  const WaitPolicyParams params_;
+  const int epoll_fd_;
+  const int timer_fd_;
+  std::vector<Stream> streams_;
+  int64_t once_arrival_ns_ {0};
+  Stats stats_;
+};
+
+}  // namespace schunk_driver
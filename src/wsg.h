@@ -1,14 +1,20 @@
 #pragma once
 
-#include <chrono>
+#include <cassert>
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <vector>
 
+#include "clock.h"
 #include "defaults.h"
+#include "trace.h"
+#include "wait_policy.h"
 #include "wsg_command_message.h"
-#include "wsg_command_sender.h"
+#include "wsg_metrics.h"
 #include "wsg_return_message.h"
-#include "wsg_return_receiver.h"
+#include "wsg_transport.h"
+#include "wsg_udp_transport.h"
 
 namespace schunk_driver {
 
@@ -30,6 +36,22 @@ struct PhysicalLimits {
   float overdrive_force_ {0};
 };
 
+/// Finger types reported by GetFingerInfo; see the command set reference.
+enum FingerType {
+  kFingerGeneric = 0,
+  kFingerForceMeasurement = 1,  //< WSG-FMF.
+  kFingerTactile = 2,  //< WSG-DSA.
+  kFingerNotConnected = 0xff,
+};
+
+struct FingerInfo {
+  uint8_t type_{kFingerNotConnected};
+  uint8_t hwrev_{0};
+  uint16_t fw_version_{0};
+  uint32_t serial_number_{0};
+  uint16_t data_size_{0};  //< Bytes of data returned by GetFingerData.
+};
+
 /// A convenience class for sending and receiving WSG messages.  There is no
 /// guiding principle to the methods here; it is just the methods we happened
 /// to need during development.
@@ -37,13 +59,22 @@ class Wsg {
  public:
   Wsg(const char* local_addr, in_port_t local_port,
       const char* gripper_addr, in_port_t gripper_port)
-      : rx_(local_addr, local_port, gripper_addr, gripper_port),
-        tx_(local_addr, local_port, gripper_addr, gripper_port) {
+      : Wsg(std::unique_ptr<WsgTransport>(new WsgUdpTransport(
+                local_addr, local_port, gripper_addr, gripper_port)),
+            SystemClock::Get()) {
   }
 
   Wsg() : Wsg(nullptr, kLocalPort, kGripperAddrStr, kGripperPort) {}
 
+  /// Communicates over @p transport, timing all waits with @p clock (which
+  /// must outlive this object).
+  Wsg(std::unique_ptr<WsgTransport> transport, Clock* clock)
+      : transport_(std::move(transport)),
+        clock_(clock) {
+  }
+
   /** Sends @p command and waits for at least @p timeout for a response.
+   * Messages for other commands that arrive meanwhile are discarded.
    * @return that response, or nullptr if no response arrived in time. */
   std::unique_ptr<WsgReturnMessage> SendAndAwaitResponse(
       const WsgCommandMessage& command,
@@ -52,19 +83,32 @@ class Wsg {
     std::cout << "sending " << command.command()
               << " and awaiting for " << timeout << " seconds." << std::endl;
 #endif
-    auto start_time = std::chrono::system_clock::now();
-    tx_.Send(command);
+    assert(!staging_);  // The response would never come.
+    TraceSpan span("wsg", "SendAndAwaitResponse");
+    span.SetArg(0, "command", command.command());
+    int discarded = 0;
+    const int64_t start_ns = clock_->NowNs();
+    Send(command);
+    if (wait_policy_) {
+      wait_policy_->ExpectOnce(start_ns + response_latency_ns_);
+    }
     std::unique_ptr<WsgReturnMessage> response(nullptr);
     while (!response) {
-      auto now = std::chrono::system_clock::now();
-      if (std::chrono::duration_cast<std::chrono::milliseconds>(
-              now - start_time).count() > (timeout * 1e3)) {
+      if (clock_->NowNs() - start_ns > (timeout * 1e9)) {
         break;
       }
-      response = rx_.Receive();
-      if (response) {
+      response = Receive();
+      if (!response) {
+        if (wait_policy_) {
+          wait_policy_->WaitUntil(start_ns + static_cast<int64_t>(
+              timeout * 1e9));
+        } else {
+          clock_->Idle();
+        }
+      } else {
         if (response->command() != command.command()) {
           response.reset(nullptr);  // Throw away irrelevant message.
+          discarded++;
         } else if (response->status() == E_CMD_PENDING) {
           response.reset(nullptr);  // Wait for a final status message.
         } else {
@@ -75,12 +119,13 @@ class Wsg {
         }
       }
     }
+    span.SetArg(1, "discarded", discarded);
     return(response);
   }
 
   /// Issues a stop command and does not await a response.
   void Stop() {
-    tx_.Send(WsgCommandMessage(kStop, {}));
+    Send(WsgCommandMessage(kStop, {}));
   }
 
   SystemInfo GetSystemInfo() {
@@ -137,6 +182,49 @@ class Wsg {
     return result;
   }
 
+  /** Gets the type and data size of finger @p index (0 or 1).  A finger that
+   * does not answer is reported as kFingerNotConnected. */
+  FingerInfo GetFingerInfo(uint8_t index) {
+    auto info_msg = SendAndAwaitResponse(
+        WsgCommandMessage(kGetFingerInfo, {index}), 0.1);
+    FingerInfo result;
+    if (!info_msg || info_msg->status() != E_SUCCESS ||
+        info_msg->params().size() < 10) {
+      return result;
+    }
+    auto info_data = info_msg->params().data();
+    memcpy(&result.type_, info_data + 0, sizeof(uint8_t));
+    memcpy(&result.hwrev_, info_data + 1, sizeof(uint8_t));
+    memcpy(&result.fw_version_, info_data + 2, sizeof(uint16_t));
+    memcpy(&result.serial_number_, info_data + 4, sizeof(uint32_t));
+    memcpy(&result.data_size_, info_data + 8, sizeof(uint16_t));
+
+    std::cout << "Finger " << static_cast<int>(index) << " info:\n";
+    std::cout << "type: " << static_cast<int>(result.type_) << " ";
+    std::cout << "hwrev: " << static_cast<int>(result.hwrev_) << " ";
+    std::cout << "fw_version: 0x" << std::hex << result.fw_version_
+              << std::dec << " ";
+    std::cout << "serial: " << result.serial_number_ << " ";
+    std::cout << "data_size: " << result.data_size_ << "\n";
+    return result;
+  }
+
+  /** Turns the power of finger @p index on or off. */
+  bool SetFingerPower(uint8_t index, bool on) {
+    WsgCommandMessage command(
+        kFingerPowerControl, {index, static_cast<unsigned char>(on ? 1 : 0)});
+    auto response = SendAndAwaitResponse(command, 0.1);
+    return response && (response->status() == E_SUCCESS);
+  }
+
+  /** Requests the current data of finger @p index.  The response carries no
+   * finger index, so callers should keep at most one request outstanding.
+   *
+   * This command does not block. */
+  void RequestFingerDataNonblocking(uint8_t index) {
+    Send(WsgCommandMessage(kGetFingerData, {index}));
+  }
+
   /// Directions the wsg can "home" in.  Positive/Default are outward.
   enum HomeDirection { kDefault, kPositive, kNegative };
 
@@ -178,7 +266,7 @@ class Wsg {
   void SetForceLimitNonblocking(double force) {
     WsgCommandMessage command(kSetForceLimit, {});
     command.AppendToPayload(static_cast<float>(force));
-    tx_.Send(command);
+    Send(command);
   }
 
   bool SetAcceleration(double acceleration_mm_per_ss) {
@@ -219,7 +307,29 @@ class Wsg {
 #ifdef DEBUG
     std::cout << "sending " << command.command() << " nonblocking" << std::endl;
 #endif
-    tx_.Send(command);
+    Send(command);
+  }
+
+  /** Issues a Grasp command to the gripper, to grasp a part of nominal
+   * width @p width_mm at the current force limit.
+   *
+   * This command does not block. */
+  void GraspNonblocking(double width_mm, double speed_mm_per_s) {
+    WsgCommandMessage command(kGrasp, {});
+    command.AppendToPayload(static_cast<float>(width_mm));
+    command.AppendToPayload(static_cast<float>(speed_mm_per_s));
+    Send(command);
+  }
+
+  /** Issues a Release command to the gripper, opening the fingers by
+   * @p pull_back_mm relative to the grasped part.
+   *
+   * This command does not block. */
+  void ReleaseNonblocking(double pull_back_mm, double speed_mm_per_s) {
+    WsgCommandMessage command(kRelease, {});
+    command.AppendToPayload(static_cast<float>(pull_back_mm));
+    command.AppendToPayload(static_cast<float>(speed_mm_per_s));
+    Send(command);
   }
 
   WsgCommandMessage PrepositionCommand(
@@ -235,7 +345,7 @@ class Wsg {
 
   /** Sets update rate for any recurring status message.
    * All of the GetWhatever commands have the same payload format, so this
-   * convenience function will update any of them to kUpdatePeriodMs.
+   * convenience function will update any of them to @p update_period_ms.
    *
    * This command blocks (for about @p update_period_ms) until the
    * configuration is complete and a message has been received. */
@@ -251,12 +361,102 @@ class Wsg {
     }
   }
 
-  WsgReturnReceiver& rx() { return rx_; }
-  WsgCommandSender& tx() { return tx_; }
+  /// Sends @p command without awaiting a response, or while staging holds
+  /// it back.
+  void Send(const WsgCommandMessage& command) {
+    if (staging_) {
+      staged_frames_.emplace_back();
+      command.Serialize(staged_frames_.back());
+      staged_commands_.push_back(command.command());
+      return;
+    }
+    sent_[command.command() & 0xff]++;
+    if (metrics_) { metrics_->CountSent(command.command()); }
+    TraceInstant("wsg", "send", "command", command.command());
+    transport_->Send(command);
+  }
+
+  /// While @p staging, holds back the messages of calls to Send(), already
+  /// serialized, for SendStaged() to send later in one burst.
+  void set_staging(bool staging) { staging_ = staging; }
+
+  /// Whether calls to Send() are being held back.
+  bool staging() const { return staging_; }
+
+  /// Whether messages held back by staging await SendStaged().
+  bool has_staged() const { return !staged_frames_.empty(); }
+
+  /// Sends every message held back by staging, back to back.
+  void SendStaged() {
+    TraceSpan span("wsg", "SendStaged");
+    span.SetArg(0, "messages", staged_frames_.size());
+    transport_->SendFrames(staged_frames_);
+    for (int command : staged_commands_) {
+      sent_[command & 0xff]++;
+      if (metrics_) { metrics_->CountSent(command); }
+    }
+    DiscardStaged();
+  }
+
+  /// Forgets every message held back by staging without sending it.
+  void DiscardStaged() {
+    staged_frames_.clear();
+    staged_commands_.clear();
+  }
+
+  /// Returns the next pending message from the gripper, or nullptr if none
+  /// is pending.  Does not block.
+  std::unique_ptr<WsgReturnMessage> Receive() {
+    std::unique_ptr<WsgReturnMessage> result = transport_->Receive();
+    if (result) {
+      if (metrics_) {
+        metrics_->CountReceived(result->command(), result->status());
+      }
+      TraceInstant("wsg", "receive", "command", result->command(),
+                   "status", result->status());
+    }
+    return result;
+  }
+
+  /// The number of messages of @p command sent so far.
+  uint64_t sent(int command) const { return sent_[command & 0xff]; }
+
+  /// See WsgTransport::receive_drops().
+  uint64_t receive_drops() const { return transport_->receive_drops(); }
+
+  /// See WsgTransport::receive_fd().
+  int receive_fd() const { return transport_->receive_fd(); }
+
+  /// Waits for responses with @p wait_policy (which must outlive this
+  /// object, and be on a SystemClock), or if it is null, polls with
+  /// Clock::Idle().
+  void set_wait_policy(WaitPolicy* wait_policy) {
+    wait_policy_ = wait_policy;
+  }
+
+  /// Sets the round trip time after which the wait policy expects the
+  /// response to each command sent by SendAndAwaitResponse().
+  void set_response_latency_ns(int64_t latency_ns) {
+    response_latency_ns_ = latency_ns;
+  }
+
+  /// Counts every message sent and received into @p metrics (which must
+  /// outlive this object), or stops counting if it is null.
+  void set_metrics(WsgMetrics* metrics) { metrics_ = metrics; }
+
+  Clock* clock() { return clock_; }
 
  private:
-  WsgReturnReceiver rx_;
-  WsgCommandSender tx_;
+  std::unique_ptr<WsgTransport> transport_;
+  Clock* const clock_;
+  WsgMetrics* metrics_ {nullptr};
+  WaitPolicy* wait_policy_ {nullptr};
+  int64_t response_latency_ns_ {0};
+  uint64_t sent_[256] {};  //< By command.
+  bool staging_ {false};
+  // Messages held back by staging, and their commands.
+  std::vector<std::vector<unsigned char>> staged_frames_;
+  std::vector<int> staged_commands_;
 };
 
 }  // namespace schunk_driver
@@ -21,6 +21,19 @@ void WsgCommandMessage::Serialize(std::vector<unsigned char>& buffer) const {
   buffer[payload_.size() + 7] = (crc >> 8) & 0xFF;
 }
 
+std::unique_ptr<WsgCommandMessage> WsgCommandMessage::Parse(
+    const unsigned char* data, size_t size) {
+  if (size < 8 || data[0] != 0xaa || data[1] != 0xaa || data[2] != 0xaa) {
+    return nullptr;
+  }
+  const size_t payload_size = data[4] + (data[5] << 8);
+  if (size != payload_size + 8) {
+    return nullptr;
+  }
+  return std::unique_ptr<WsgCommandMessage>(new WsgCommandMessage(
+      data[3], std::vector<unsigned char>(data + 6, data + 6 + payload_size)));
+}
+
 template <typename T>
 void WsgCommandMessage::AppendToPayload(const T& new_item) {
   size_t old_size = payload_.size();
@@ -31,6 +44,7 @@ void WsgCommandMessage::AppendToPayload(const T& new_item) {
 template void WsgCommandMessage::AppendToPayload(const unsigned char& new_item);
 template void WsgCommandMessage::AppendToPayload(const uint16_t& new_item);
 template void WsgCommandMessage::AppendToPayload(const uint32_t& new_item);
+template void WsgCommandMessage::AppendToPayload(const int64_t& new_item);
 template void WsgCommandMessage::AppendToPayload(const float& new_item);
 
 }  // namespace schunk_driver
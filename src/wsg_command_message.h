@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <memory>
 #include <vector>
 
 namespace schunk_driver {
@@ -58,6 +60,12 @@ class WsgCommandMessage {
 
   void Serialize(std::vector<unsigned char>& buffer) const;
 
+  /// Parses a single command frame of @p size bytes at @p data, as sent by
+  /// Serialize(), for use by simulated grippers.  Returns nullptr if the
+  /// frame is malformed.
+  static std::unique_ptr<WsgCommandMessage> Parse(const unsigned char* data,
+                                                  size_t size);
+
  private:
   const int command_;
   std::vector<unsigned char> payload_;
@@ -8,6 +8,7 @@
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <vector>
@@ -52,4 +53,29 @@ void WsgCommandSender::Send(const WsgCommandMessage& msg) {
 #endif
 }
 
+void WsgCommandSender::SendFrames(
+    const std::vector<std::vector<unsigned char>>& frames) {
+  std::vector<struct iovec> iovecs(frames.size());
+  std::vector<struct mmsghdr> headers(frames.size());
+  for (size_t i = 0; i < frames.size(); i++) {
+    iovecs[i].iov_base = const_cast<unsigned char*>(frames[i].data());
+    iovecs[i].iov_len = frames[i].size();
+    struct msghdr& header = headers[i].msg_hdr;
+    header = {};
+    header.msg_name = const_cast<struct sockaddr_in*>(&gripper_sockaddr_);
+    header.msg_namelen = sizeof(struct sockaddr_in);
+    header.msg_iov = &iovecs[i];
+    header.msg_iovlen = 1;
+  }
+  // sendmmsg() may stop short, eg when interrupted; send the rest.
+  size_t sent = 0;
+  while (sent < headers.size()) {
+    int send_result = sendmmsg(fd_, headers.data() + sent,
+                               headers.size() - sent, 0);
+    assert(send_result > 0);
+    if (send_result <= 0) { break; }
+    sent += send_result;
+  }
+}
+
 }  // namespace schunk_driver
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include <netinet/in.h>
 
 #include "wsg_command_message.h"
@@ -15,6 +17,10 @@ class WsgCommandSender {
 
   void Send(const WsgCommandMessage& msg);
 
+  /// Sends @p frames, each already serialized, as one datagram apiece but
+  /// with a single sendmmsg() call.
+  void SendFrames(const std::vector<std::vector<unsigned char>>& frames);
+
  private:
   const int fd_;
   const struct sockaddr_in local_sockaddr_;
@@ -0,0 +1,254 @@
+#include "wsg_metrics.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include "wsg_return_message.h"
+
+namespace schunk_driver {
+namespace {
+
+// Upper bounds of the tick duration histogram buckets, in seconds.
+const double kTickBucketBounds[] = {
+  0.0001, 0.0005, 0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1};
+
+const char* const kStatusCodeNames[] = {
+  "E_SUCCESS", "E_NOT_AVAILABLE", "E_NO_SENSOR", "E_NOT_INITIALIZED",
+  "E_ALREADY_RUNNING", "E_FEATURE_NOT_SUPPORTED", "E_INCONSISTENT_DATA",
+  "E_TIMEOUT", "E_READ_ERROR", "E_WRITE_ERROR", "E_INSUFFICIENT_RESOURCES",
+  "E_CHECKSUM_ERROR", "E_NO_PARAM_EXPECTED", "E_NOT_ENOUGH_PARAMS",
+  "E_CMD_UNKNOWN", "E_CMD_FORMAT_ERROR", "E_ACCESS_DENIED", "E_ALREADY_OPEN",
+  "E_CMD_FAILED", "E_CMD_ABORTED", "E_INVALID_HANDLE", "E_NOT_FOUND",
+  "E_NOT_OPEN", "E_IO_ERROR", "E_INVALID_PARAMETER", "E_INDEX_OUT_OF_BOUNDS",
+  "E_CMD_PENDING", "E_OVERRUN", "E_RANGE_ERROR", "E_AXIS_BLOCKED",
+  "E_FILE_EXISTS"};
+
+// Formats @p ns as seconds to the nanosecond.  The stream default of six
+// significant digits would freeze a seconds counter after some minutes.
+std::string Seconds(int64_t ns) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.9f", ns / 1e9);
+  return buffer;
+}
+
+struct FlagName {
+  StateFlag flag;
+  const char* name;
+};
+
+const FlagName kFaultFlags[] = {
+  {SF_SCRIPT_FAILURE, "SF_SCRIPT_FAILURE"},
+  {SF_CMD_FAILURE, "SF_CMD_FAILURE"},
+  {SF_FINGER_FAULT, "SF_FINGER_FAULT"},
+  {SF_CURR_FAULT, "SF_CURR_FAULT"},
+  {SF_POWER_FAULT, "SF_POWER_FAULT"},
+  {SF_TEMP_FAULT, "SF_TEMP_FAULT"},
+  {SF_TEMP_WARNING, "SF_TEMP_WARNING"},
+  {SF_FAST_STOP, "SF_FAST_STOP"},
+  {SF_BLOCKED_PLUS, "SF_BLOCKED_PLUS"},
+  {SF_BLOCKED_MINUS, "SF_BLOCKED_MINUS"},
+  {SF_REFERENCED, "SF_REFERENCED"},
+};
+
+template <typename T>
+T Load(const std::atomic<T>& value) {
+  return value.load(std::memory_order_relaxed);
+}
+
+void WriteCommandCounts(const std::atomic<uint64_t>* counts,
+                        const char* direction, const std::string& gripper,
+                        std::ostream& out) {
+  for (int command = 0; command < 256; command++) {
+    const uint64_t count = Load(counts[command]);
+    if (count == 0) { continue; }
+    out << "schunk_wsg_packets_total{gripper=\"" << gripper
+        << "\",direction=\"" << direction << "\",command=\"" << command
+        << "\"} " << count << "\n";
+  }
+}
+
+}  // namespace
+
+WsgMetrics::WsgMetrics() {
+  for (auto& count : sent_) { count.store(0, std::memory_order_relaxed); }
+  for (auto& count : received_) { count.store(0, std::memory_order_relaxed); }
+  for (auto& count : errors_) { count.store(0, std::memory_order_relaxed); }
+  for (auto& count : tick_buckets_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  recommands_issued_.store(0, std::memory_order_relaxed);
+  recommands_suppressed_.store(0, std::memory_order_relaxed);
+  system_state_.store(0, std::memory_order_relaxed);
+  temperature_.store(NAN, std::memory_order_relaxed);
+  socket_drops_.store(0, std::memory_order_relaxed);
+  wait_spin_ns_.store(0, std::memory_order_relaxed);
+  wait_block_ns_.store(0, std::memory_order_relaxed);
+  group_releases_.store(0, std::memory_order_relaxed);
+  group_release_lateness_ns_.store(0, std::memory_order_relaxed);
+  group_skews_.store(0, std::memory_order_relaxed);
+  group_skew_ns_.store(0, std::memory_order_relaxed);
+  tick_sum_ns_.store(0, std::memory_order_relaxed);
+}
+
+void WsgMetrics::CountSent(int command) {
+  sent_[command & 0xff].fetch_add(1, std::memory_order_relaxed);
+}
+
+void WsgMetrics::CountReceived(int command, int status) {
+  received_[command & 0xff].fetch_add(1, std::memory_order_relaxed);
+  if (status != E_SUCCESS) {
+    const int index = (status >= 0 && status < kNumStatusCodes)
+        ? status : kNumStatusCodes - 1;
+    errors_[index].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void WsgMetrics::CountRecommand(bool issued) {
+  (issued ? recommands_issued_ : recommands_suppressed_).fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+void WsgMetrics::SetSystemState(uint32_t system_state) {
+  system_state_.store(system_state, std::memory_order_relaxed);
+}
+
+void WsgMetrics::SetTemperature(double celsius) {
+  temperature_.store(celsius, std::memory_order_relaxed);
+}
+
+void WsgMetrics::SetSocketDrops(uint64_t drops) {
+  socket_drops_.store(drops, std::memory_order_relaxed);
+}
+
+void WsgMetrics::SetWaitTimes(int64_t spin_ns, int64_t block_ns) {
+  wait_spin_ns_.store(spin_ns, std::memory_order_relaxed);
+  wait_block_ns_.store(block_ns, std::memory_order_relaxed);
+}
+
+void WsgMetrics::RecordGroupRelease(int64_t lateness_ns) {
+  group_release_lateness_ns_.store(lateness_ns, std::memory_order_relaxed);
+  group_releases_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WsgMetrics::RecordGroupSkew(int64_t skew_ns) {
+  group_skew_ns_.store(skew_ns, std::memory_order_relaxed);
+  group_skews_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WsgMetrics::RecordTick(int64_t duration_ns) {
+  int bucket = 0;
+  while (bucket < kNumTickBuckets - 1 &&
+         duration_ns > kTickBucketBounds[bucket] * 1e9) {
+    bucket++;
+  }
+  tick_buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+  tick_sum_ns_.fetch_add(duration_ns, std::memory_order_relaxed);
+}
+
+void WsgMetrics::WriteOpenMetrics(const std::string& gripper,
+                                  std::ostream& out) const {
+  const std::string label = "gripper=\"" + gripper + "\"";
+
+  out << "# TYPE schunk_wsg_packets counter\n"
+      << "# HELP schunk_wsg_packets Messages exchanged with the gripper, by "
+      << "command ID.\n";
+  WriteCommandCounts(sent_, "out", gripper, out);
+  WriteCommandCounts(received_, "in", gripper, out);
+
+  out << "# TYPE schunk_wsg_error_responses counter\n"
+      << "# HELP schunk_wsg_error_responses Responses with a status other "
+      << "than E_SUCCESS.\n";
+  const int num_names = sizeof(kStatusCodeNames) / sizeof(*kStatusCodeNames);
+  for (int status = 1; status < kNumStatusCodes; status++) {
+    const uint64_t count = Load(errors_[status]);
+    if (count == 0) { continue; }
+    out << "schunk_wsg_error_responses_total{" << label << ",status=\""
+        << (status < num_names ? kStatusCodeNames[status] : "other")
+        << "\"} " << count << "\n";
+  }
+
+  out << "# TYPE schunk_wsg_recommands counter\n"
+      << "# HELP schunk_wsg_recommands Control decisions to recommand the "
+      << "gripper, or not because of a deadband.\n"
+      << "schunk_wsg_recommands_total{" << label << ",decision=\"issued\"} "
+      << Load(recommands_issued_) << "\n"
+      << "schunk_wsg_recommands_total{" << label
+      << ",decision=\"suppressed\"} " << Load(recommands_suppressed_) << "\n";
+
+  out << "# TYPE schunk_wsg_state_flag gauge\n"
+      << "# HELP schunk_wsg_state_flag System state flags from the most "
+      << "recent status.\n";
+  const uint32_t system_state = Load(system_state_);
+  for (const FlagName& flag : kFaultFlags) {
+    out << "schunk_wsg_state_flag{" << label << ",flag=\"" << flag.name
+        << "\"} " << ((system_state & flag.flag) ? 1 : 0) << "\n";
+  }
+
+  const double temperature = Load(temperature_);
+  if (!std::isnan(temperature)) {
+    out << "# TYPE schunk_wsg_temperature_celsius gauge\n"
+        << "# UNIT schunk_wsg_temperature_celsius celsius\n"
+        << "schunk_wsg_temperature_celsius{" << label << "} "
+        << temperature << "\n";
+  }
+
+  out << "# TYPE schunk_wsg_socket_drops counter\n"
+      << "# HELP schunk_wsg_socket_drops Datagrams from the gripper dropped "
+      << "by the kernel.\n"
+      << "schunk_wsg_socket_drops_total{" << label << "} "
+      << Load(socket_drops_) << "\n";
+
+  out << "# TYPE schunk_wsg_wait_seconds counter\n"
+      << "# UNIT schunk_wsg_wait_seconds seconds\n"
+      << "# HELP schunk_wsg_wait_seconds Time spent waiting for messages, "
+      << "by whether the wait spun or blocked.\n"
+      << "schunk_wsg_wait_seconds_total{" << label << ",mode=\"spin\"} "
+      << Seconds(Load(wait_spin_ns_)) << "\n"
+      << "schunk_wsg_wait_seconds_total{" << label << ",mode=\"block\"} "
+      << Seconds(Load(wait_block_ns_)) << "\n";
+
+  out << "# TYPE schunk_wsg_group_releases counter\n"
+      << "# HELP schunk_wsg_group_releases Group commands sent.\n"
+      << "schunk_wsg_group_releases_total{" << label << "} "
+      << Load(group_releases_) << "\n";
+  if (Load(group_releases_) > 0) {
+    out << "# TYPE schunk_wsg_group_release_lateness_seconds gauge\n"
+        << "# UNIT schunk_wsg_group_release_lateness_seconds seconds\n"
+        << "# HELP schunk_wsg_group_release_lateness_seconds Time from the "
+        << "release time of the latest group command to its sending.\n"
+        << "schunk_wsg_group_release_lateness_seconds{" << label << "} "
+        << Seconds(Load(group_release_lateness_ns_)) << "\n";
+  }
+  if (Load(group_skews_) > 0) {
+    out << "# TYPE schunk_wsg_group_skew_seconds gauge\n"
+        << "# UNIT schunk_wsg_group_skew_seconds seconds\n"
+        << "# HELP schunk_wsg_group_skew_seconds Spread of the times at "
+        << "which the drivers of the latest fully reported group command "
+        << "sent it.\n"
+        << "schunk_wsg_group_skew_seconds{" << label << "} "
+        << Seconds(Load(group_skew_ns_)) << "\n";
+  }
+
+  out << "# TYPE schunk_wsg_tick_seconds histogram\n"
+      << "# UNIT schunk_wsg_tick_seconds seconds\n"
+      << "# HELP schunk_wsg_tick_seconds Duration of driver loop ticks.\n";
+  uint64_t cumulative = 0;
+  for (int bucket = 0; bucket < kNumTickBuckets; bucket++) {
+    cumulative += Load(tick_buckets_[bucket]);
+    out << "schunk_wsg_tick_seconds_bucket{" << label << ",le=\"";
+    if (bucket < kNumTickBuckets - 1) {
+      out << kTickBucketBounds[bucket];
+    } else {
+      out << "+Inf";
+    }
+    out << "\"} " << cumulative << "\n";
+  }
+  out << "schunk_wsg_tick_seconds_count{" << label << "} " << cumulative
+      << "\n"
+      << "schunk_wsg_tick_seconds_sum{" << label << "} "
+      << Seconds(Load(tick_sum_ns_)) << "\n";
+
+  out << "# EOF\n";
+}
+
+}  // namespace schunk_driver
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace schunk_driver {
+
+/// Operational counters and gauges for one gripper, exposed in OpenMetrics
+/// text format.  Every update is a single relaxed atomic operation, so the
+/// control loop may record freely while another thread reads a snapshot;
+/// the snapshot is consistent per value but not across values.
+class WsgMetrics {
+ public:
+  WsgMetrics();
+
+  void CountSent(int command);
+  /// Counts a received message, and its status if not E_SUCCESS.
+  void CountReceived(int command, int status);
+  /// Counts a recommand decision: @p issued if a command went out, or
+  /// suppressed by a deadband if not.
+  void CountRecommand(bool issued);
+
+  void SetSystemState(uint32_t system_state);
+  void SetTemperature(double celsius);
+  /// Sets the total datagrams the kernel dropped for want of buffer space.
+  void SetSocketDrops(uint64_t drops);
+  /// Sets the total time spent spinning and blocking while waiting for
+  /// messages (see WaitPolicy).
+  void SetWaitTimes(int64_t spin_ns, int64_t block_ns);
+  /// Records the release of a group command @p lateness_ns after its
+  /// release time.
+  void RecordGroupRelease(int64_t lateness_ns);
+  /// Records the inter-gripper skew measured for a group command.
+  void RecordGroupSkew(int64_t skew_ns);
+  /// Records the duration of one driver loop tick.
+  void RecordTick(int64_t duration_ns);
+
+  /// Writes every metric, labeled with @p gripper, followed by the
+  /// terminating "# EOF".
+  void WriteOpenMetrics(const std::string& gripper, std::ostream& out) const;
+
+ private:
+  static const int kNumCommands = 256;
+  // Status codes beyond the last known one share the final slot.
+  static const int kNumStatusCodes = 32;
+  static const int kNumTickBuckets = 10;
+
+  std::atomic<uint64_t> sent_[kNumCommands];
+  std::atomic<uint64_t> received_[kNumCommands];
+  std::atomic<uint64_t> errors_[kNumStatusCodes];
+  std::atomic<uint64_t> recommands_issued_;
+  std::atomic<uint64_t> recommands_suppressed_;
+  std::atomic<uint32_t> system_state_;
+  std::atomic<double> temperature_;
+  std::atomic<uint64_t> socket_drops_;
+  std::atomic<int64_t> wait_spin_ns_;
+  std::atomic<int64_t> wait_block_ns_;
+  std::atomic<uint64_t> group_releases_;
+  std::atomic<int64_t> group_release_lateness_ns_;  //< The latest's.
+  std::atomic<uint64_t> group_skews_;
+  std::atomic<int64_t> group_skew_ns_;  //< The latest's.
+  // Non-cumulative counts per bucket; the last bucket is +Inf.
+  std::atomic<uint64_t> tick_buckets_[kNumTickBuckets];
+  std::atomic<int64_t> tick_sum_ns_;
+};
+
+}  // namespace schunk_driver
@@ -3,6 +3,8 @@
 #include <cassert>
 #include <cstring>
 
+#include "crc.h"
+
 namespace schunk_driver {
 
 std::unique_ptr<WsgReturnMessage>
@@ -24,5 +26,21 @@ WsgReturnMessage::Parse(std::vector<unsigned char>& buffer) {
       new WsgReturnMessage(command, status_code, params));
 }
 
+void WsgReturnMessage::Serialize(std::vector<unsigned char>& buffer) const {
+  const size_t payload_size = params_.size() + 2;
+  buffer.resize(payload_size + 8);
+  buffer[0] = 0xaa;
+  buffer[1] = 0xaa;
+  buffer[2] = 0xaa;
+  buffer[3] = command_ & 0xff;
+  buffer[4] = payload_size & 0xff;
+  buffer[5] = (payload_size >> 8) & 0xff;
+  buffer[6] = status_ & 0xff;
+  buffer[7] = (status_ >> 8) & 0xff;
+  memcpy(buffer.data() + 8, params_.data(), params_.size());
+  uint16_t crc = checksum_update_crc16(buffer.data(), payload_size + 6);
+  buffer[payload_size + 6] = crc & 0xff;
+  buffer[payload_size + 7] = (crc >> 8) & 0xff;
+}
 
 }  // namespace schunk_driver
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -91,13 +92,23 @@ class WsgReturnMessage {
   int status() const { return status_; }
   const std::vector<unsigned char>& params() const { return params_; }
 
+  /// Host wall-clock time (nanoseconds since the epoch) at which this
+  /// message arrived, as stamped by the kernel where available.
+  int64_t receive_time_ns() const { return receive_time_ns_; }
+  void set_receive_time_ns(int64_t time_ns) { receive_time_ns_ = time_ns; }
+
   static std::unique_ptr<WsgReturnMessage> Parse(
       std::vector<unsigned char>& buffer);
 
+  /// Serializes this message into @p buffer as the gripper would send it,
+  /// for use by simulated grippers.
+  void Serialize(std::vector<unsigned char>& buffer) const;
+
  private:
   const int command_;
   const int status_;
   const std::vector<unsigned char> params_;
+  int64_t receive_time_ns_ {0};
 };
 
 }
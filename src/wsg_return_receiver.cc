@@ -4,7 +4,10 @@
 #include <cstdlib>
 #include <cstring>
 #include <iomanip>
+#include <ctime>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 
 #include <arpa/inet.h>
 #include <sys/socket.h>
@@ -28,11 +31,25 @@ WsgReturnReceiver::WsgReturnReceiver(
               .sin_port = htons(gripper_port),
               .sin_addr = { inet_addr(gripper_addr) }}) {
   assert(fd_ > 0);
+  // Ask the kernel to stamp each datagram with its arrival time.
+  int enable = 1;
+  if (setsockopt(fd_, SOL_SOCKET, SO_TIMESTAMPNS,
+                 &enable, sizeof(enable)) != 0) {
+    std::cerr << "SO_TIMESTAMPNS unavailable: " << errno << std::endl;
+  }
+  // And with the count of datagrams dropped for lack of buffer space.
+  if (setsockopt(fd_, SOL_SOCKET, SO_RXQ_OVFL,
+                 &enable, sizeof(enable)) != 0) {
+    std::cerr << "SO_RXQ_OVFL unavailable: " << errno << std::endl;
+  }
   int bind_result = bind(fd_, (struct sockaddr *) &local_sockaddr_,
                          sizeof(struct sockaddr_in));
   if (bind_result != 0) {
-    std::cerr << "bind failed: " << errno << std::endl;
-    assert(bind_result == 0);
+    const std::string error = strerror(errno);
+    close(fd_);
+    throw std::runtime_error("bind of local port " +
+                             std::to_string(local_port) + " failed: " +
+                             error);
   }
 }
 
@@ -41,10 +58,18 @@ WsgReturnReceiver::~WsgReturnReceiver() { close(fd_); }
 std::unique_ptr<WsgReturnMessage> WsgReturnReceiver::Receive() {
   unsigned char buffer[1024];
   struct sockaddr_storage src_sockaddr;
-  socklen_t src_sockaddr_len = sizeof(src_sockaddr);
-  ssize_t read_size = recvfrom(
-      fd_, buffer, sizeof(buffer), MSG_DONTWAIT,
-      (struct sockaddr*) &src_sockaddr, &src_sockaddr_len);
+  struct iovec iov = { buffer, sizeof(buffer) };
+  char control[CMSG_SPACE(sizeof(struct timespec)) +
+               CMSG_SPACE(sizeof(uint32_t))];
+  struct msghdr header;
+  memset(&header, 0, sizeof(header));
+  header.msg_name = &src_sockaddr;
+  header.msg_namelen = sizeof(src_sockaddr);
+  header.msg_iov = &iov;
+  header.msg_iovlen = 1;
+  header.msg_control = control;
+  header.msg_controllen = sizeof(control);
+  ssize_t read_size = recvmsg(fd_, &header, MSG_DONTWAIT);
   // TODO(ggould-tri) check that src_sockaddr matchines gripper_sockaddr_
 
   if (read_size < 0) {
@@ -63,7 +88,39 @@ std::unique_ptr<WsgReturnMessage> WsgReturnReceiver::Receive() {
   } else {
     std::vector<unsigned char> message_buffer(read_size);
     memcpy(message_buffer.data(), buffer, read_size);
-    return WsgReturnMessage::Parse(message_buffer);
+    std::unique_ptr<WsgReturnMessage> result =
+        WsgReturnMessage::Parse(message_buffer);
+    result->set_receive_time_ns(ReceiveTimeNs(header));
+    ReadDrops(header, &drops_);
+    return result;
+  }
+}
+
+int64_t WsgReturnReceiver::ReceiveTimeNs(const struct msghdr& header) {
+  struct timespec time;
+  bool stamped = false;
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&header); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(const_cast<struct msghdr*>(&header), cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET &&
+        cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+      memcpy(&time, CMSG_DATA(cmsg), sizeof(time));
+      stamped = true;
+    }
+  }
+  if (!stamped) {
+    // Fall back to the time of reading if the kernel did not stamp it.
+    clock_gettime(CLOCK_REALTIME, &time);
+  }
+  return time.tv_sec * 1000000000L + time.tv_nsec;
+}
+
+void WsgReturnReceiver::ReadDrops(const struct msghdr& header,
+                                  uint32_t* drops) {
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&header); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(const_cast<struct msghdr*>(&header), cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+      memcpy(drops, CMSG_DATA(cmsg), sizeof(*drops));
+    }
   }
 }
 
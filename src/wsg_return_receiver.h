@@ -1,6 +1,7 @@
 #pragma once
 
 #include <netinet/in.h>
+#include <sys/socket.h>
 
 #include "wsg_return_message.h"
 
@@ -8,17 +9,32 @@ namespace schunk_driver {
 
 class WsgReturnReceiver {
  public:
+  /// Binds @p local_port to receive from the gripper.  Throws
+  /// std::runtime_error if the port cannot be bound (eg because another
+  /// driver still holds it).
   WsgReturnReceiver(const char* local_addr, in_port_t local_port,
                     const char* gripper_addr, in_port_t gripper_port);
 
   ~WsgReturnReceiver();
 
+  /// Returns the next pending message, or nullptr if none is pending.  The
+  /// message is stamped with its kernel receive time.  Does not block.
   std::unique_ptr<WsgReturnMessage> Receive();
 
+  /// Datagrams the kernel has dropped from this socket's full receive
+  /// buffer, as of the last Receive() (where SO_RXQ_OVFL is supported).
+  uint32_t drops() const { return drops_; }
+
+  int fd() const { return fd_; }
+
  private:
+  static int64_t ReceiveTimeNs(const struct msghdr& header);
+  static void ReadDrops(const struct msghdr& header, uint32_t* drops);
+
   const int fd_;
   const struct sockaddr_in local_sockaddr_;
   const struct sockaddr_in gripper_sockaddr_;
+  uint32_t drops_ {0};
 };
 
 }  // namespace schunk_driver
@@ -0,0 +1,402 @@
+#include "wsg_simulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace schunk_driver {
+
+namespace {
+
+// A grasp that closes this far past its nominal width without contact finds
+// no part.
+const double kGraspToleranceMm = 10;
+
+// Positions within this distance of a motion's target have reached it.
+const double kPositionToleranceMm = 0.05;
+
+template <typename T>
+T ReadParam(const std::vector<unsigned char>& payload, size_t offset) {
+  T result{};
+  if (payload.size() >= offset + sizeof(T)) {
+    memcpy(&result, payload.data() + offset, sizeof(T));
+  }
+  return result;
+}
+
+}  // namespace
+
+WsgSimulator::WsgSimulator(const WsgSimulatorParams& params)
+    : params_(params),
+      width_mm_(params.stroke_mm / 2),
+      force_limit_(params.nominal_force),
+      acceleration_(params.max_acc_mm_per_ss) {}
+
+uint64_t WsgSimulator::commands_received(int command) const {
+  auto found = commands_received_by_type_.find(command);
+  return (found == commands_received_by_type_.end()) ? 0 : found->second;
+}
+
+void WsgSimulator::HandleCommand(const WsgCommandMessage& command,
+                                 int64_t now_ns) {
+  Step(now_ns);
+  commands_received_++;
+  commands_received_by_type_[command.command()]++;
+  const std::vector<unsigned char> payload = command.payload();
+  switch (command.command()) {
+    case kLoop: {
+      Respond(kLoop, E_SUCCESS, payload, now_ns);
+      break;
+    }
+    case kHome: {
+      const uint8_t direction = ReadParam<uint8_t>(payload, 0);
+      StartMotion(kHome, kMotionHome,
+                  (direction == 2) ? 0 : params_.stroke_mm,
+                  params_.max_speed_mm_per_s, now_ns);
+      break;
+    }
+    case kPrePosition: {
+      const uint8_t flags = ReadParam<uint8_t>(payload, 0);
+      double target = ReadParam<float>(payload, 1);
+      if (flags & 2) { target += width_mm_; }  // Relative motion.
+      StartMotion(kPrePosition, kMotionPreposition, target,
+                  ReadParam<float>(payload, 5), now_ns);
+      motion_stop_on_block_ = flags & 1;
+      break;
+    }
+    case kGrasp: {
+      if (grasping_state_ == kHolding || grasping_state_ == kGrasping) {
+        Respond(kGrasp, E_ALREADY_RUNNING, {}, now_ns);
+        break;
+      }
+      StartMotion(kGrasp, kMotionGrasp,
+                  ReadParam<float>(payload, 0) - kGraspToleranceMm,
+                  ReadParam<float>(payload, 4), now_ns);
+      grasping_state_ = kGrasping;
+      grasps_++;
+      break;
+    }
+    case kRelease: {
+      StartMotion(kRelease, kMotionRelease,
+                  width_mm_ + ReadParam<float>(payload, 0),
+                  ReadParam<float>(payload, 4), now_ns);
+      grasping_state_ = kReleasing;
+      break;
+    }
+    case kStop:
+    case kFastStop: {
+      if (motion_ != kMotionNone) { FinishMotion(E_CMD_ABORTED, now_ns); }
+      speed_mm_per_s_ = 0;
+      Respond(command.command(), E_SUCCESS, {}, now_ns);
+      break;
+    }
+    case kAcknowledgeStopOrFault:
+    case kClearSoftLimits:
+    case kSetSoftLimits:
+    case kFingerPowerControl: {
+      Respond(command.command(), E_SUCCESS, {}, now_ns);
+      break;
+    }
+    case kSetAccel: {
+      acceleration_ = std::min(
+          static_cast<double>(ReadParam<float>(payload, 0)),
+          params_.max_acc_mm_per_ss);
+      Respond(kSetAccel, E_SUCCESS, {}, now_ns);
+      break;
+    }
+    case kSetForceLimit: {
+      force_limit_ = std::min(static_cast<double>(ReadParam<float>(payload, 0)),
+                              params_.overdrive_force);
+      Respond(kSetForceLimit, E_SUCCESS, {}, now_ns);
+      break;
+    }
+    case kTareForceSensor: {
+      // As on the real device with the internal force estimate.
+      Respond(kTareForceSensor, E_NOT_AVAILABLE, {}, now_ns);
+      break;
+    }
+    case kGetSystemState:
+    case kGetGraspState:
+    case kGetOpeningWidth:
+    case kGetSpeed:
+    case kGetForce:
+    case kGetTemperature: {
+      const uint8_t flags = ReadParam<uint8_t>(payload, 0);
+      const uint16_t period_ms = ReadParam<uint16_t>(payload, 1);
+      if (payload.size() >= 3 && (flags & 1) && period_ms > 0) {
+        const int64_t period_ns = period_ms * 1000000L;
+        updates_[command.command()] =
+            std::make_pair(period_ns, now_ns + period_ns);
+      } else if (payload.size() >= 3) {
+        updates_.erase(command.command());
+      }
+      RespondWithStatus(command.command(), now_ns);
+      break;
+    }
+    case kGetGraspStats: {
+      // Total grasps, then those that found no part and those that lost it.
+      std::vector<unsigned char> stats(8);
+      const uint32_t total = grasps_;
+      const uint16_t no_part_found = grasps_no_part_found_;
+      const uint16_t part_lost = grasps_part_lost_;
+      memcpy(stats.data(), &total, sizeof(total));
+      memcpy(stats.data() + 4, &no_part_found, sizeof(no_part_found));
+      memcpy(stats.data() + 6, &part_lost, sizeof(part_lost));
+      if (ReadParam<uint8_t>(payload, 0) & 1) {  // Reset after reading.
+        grasps_ = 0;
+        grasps_no_part_found_ = 0;
+        grasps_part_lost_ = 0;
+      }
+      Respond(kGetGraspStats, E_SUCCESS, stats, now_ns);
+      break;
+    }
+    case kGetSystemInfo: {
+      std::vector<unsigned char> info(8, 0);
+      info[0] = 1;  // Type.
+      Respond(kGetSystemInfo, E_SUCCESS, info, now_ns);
+      break;
+    }
+    case kGetSystemLimits: {
+      const float limits[] = {
+        static_cast<float>(params_.stroke_mm),
+        5.f,
+        static_cast<float>(params_.max_speed_mm_per_s),
+        100.f,
+        static_cast<float>(params_.max_acc_mm_per_ss),
+        static_cast<float>(params_.min_force),
+        static_cast<float>(params_.nominal_force),
+        static_cast<float>(params_.overdrive_force)};
+      std::vector<unsigned char> data(sizeof(limits));
+      memcpy(data.data(), limits, sizeof(limits));
+      Respond(kGetSystemLimits, E_SUCCESS, data, now_ns);
+      break;
+    }
+    case kGetFingerInfo: {
+      std::vector<unsigned char> info(10, 0);
+      info[0] = 0xff;  // Not connected.
+      Respond(kGetFingerInfo, E_SUCCESS, info, now_ns);
+      break;
+    }
+    case kGetFingerData: {
+      Respond(kGetFingerData, E_NOT_AVAILABLE, {}, now_ns);
+      break;
+    }
+    default: {
+      Respond(command.command(), E_CMD_UNKNOWN, {}, now_ns);
+      break;
+    }
+  }
+}
+
+void WsgSimulator::Step(int64_t now_ns) {
+  if (last_step_ns_ == 0) { last_step_ns_ = now_ns; }
+  if (now_ns > last_step_ns_) {
+    Integrate((now_ns - last_step_ns_) * 1e-9, now_ns);
+    last_step_ns_ = now_ns;
+  }
+  for (auto& update : updates_) {
+    std::pair<int64_t, int64_t>& schedule = update.second;
+    if (now_ns >= schedule.second) {
+      RespondWithStatus(update.first, now_ns);
+      // Skip, rather than burst, any periods missed by a coarse step.
+      while (schedule.second <= now_ns) { schedule.second += schedule.first; }
+    }
+  }
+}
+
+std::unique_ptr<WsgReturnMessage> WsgSimulator::TakeResponse(int64_t now_ns) {
+  if (responses_.empty() || responses_.front().first > now_ns) {
+    return nullptr;
+  }
+  std::unique_ptr<WsgReturnMessage> result =
+      std::move(responses_.front().second);
+  responses_.pop_front();
+  return result;
+}
+
+void WsgSimulator::Respond(int command, int status,
+                           const std::vector<unsigned char>& params,
+                           int64_t now_ns) {
+  responses_.emplace_back(
+      now_ns + params_.response_latency_ns,
+      std::unique_ptr<WsgReturnMessage>(
+          new WsgReturnMessage(command, status, params)));
+}
+
+template <typename T>
+void WsgSimulator::RespondWith(int command, const T& value, int64_t now_ns) {
+  std::vector<unsigned char> data(sizeof(T));
+  memcpy(data.data(), &value, sizeof(T));
+  Respond(command, E_SUCCESS, data, now_ns);
+}
+
+void WsgSimulator::RespondWithStatus(int command, int64_t now_ns) {
+  switch (command) {
+    case kGetSystemState: {
+      RespondWith(command, SystemState(), now_ns);
+      break;
+    }
+    case kGetGraspState: {
+      RespondWith(command, static_cast<uint8_t>(grasping_state_), now_ns);
+      break;
+    }
+    case kGetOpeningWidth: {
+      RespondWith(command, static_cast<float>(width_mm_), now_ns);
+      break;
+    }
+    case kGetSpeed: {
+      RespondWith(command, static_cast<float>(speed_mm_per_s_), now_ns);
+      break;
+    }
+    case kGetForce: {
+      RespondWith(command, static_cast<float>(force_), now_ns);
+      break;
+    }
+    case kGetTemperature: {
+      RespondWith(command, static_cast<uint16_t>(350), now_ns);  // 35.0 C.
+      break;
+    }
+  }
+}
+
+void WsgSimulator::StartMotion(int command, MotionType type, double target_mm,
+                               double speed_mm_per_s, int64_t now_ns) {
+  if (motion_ != kMotionNone) {
+    // A new motion preempts the old one, as on the device.
+    FinishMotion(E_CMD_ABORTED, now_ns);
+  }
+  motion_ = type;
+  motion_command_ = command;
+  motion_target_mm_ = std::max(0.0, std::min(target_mm, params_.stroke_mm));
+  motion_speed_mm_per_s_ = std::min(std::fabs(speed_mm_per_s),
+                                    params_.max_speed_mm_per_s);
+  motion_stop_on_block_ = false;
+  Respond(command, E_CMD_PENDING, {}, now_ns);
+}
+
+void WsgSimulator::FinishMotion(int status, int64_t now_ns) {
+  Respond(motion_command_, status, {}, now_ns);
+  motion_ = kMotionNone;
+}
+
+void WsgSimulator::Integrate(double dt, int64_t now_ns) {
+  const bool part_present = params_.part_width_mm > 0;
+  const double stiffness = params_.part_stiffness_n_per_mm;
+
+  if (grasping_state_ == kHolding) {
+    if (!part_present) {
+      // The part is gone; the fingers close on nothing.
+      grasping_state_ = kPartLost;
+      grasps_part_lost_++;
+      speed_mm_per_s_ = 0;
+    } else {
+      // The firmware holds the part at the (possibly changed) force limit.
+      width_mm_ = params_.part_width_mm - force_limit_ / stiffness;
+      force_ = force_limit_;
+      speed_mm_per_s_ = 0;
+      return;
+    }
+  }
+
+  if (motion_ == kMotionNone || motion_ == kMotionClamp) {
+    speed_mm_per_s_ = 0;
+    if (motion_ == kMotionClamp && part_present) {
+      width_mm_ = params_.part_width_mm - force_limit_ / stiffness;
+      force_ = force_limit_;
+    } else if (!(part_present && width_mm_ < params_.part_width_mm)) {
+      force_ = 0;
+    }
+    return;
+  }
+
+  // Accelerate toward the speed that would just stop at the target.
+  const double error = motion_target_mm_ - width_mm_;
+  const double direction = (error > 0) ? 1 : -1;
+  const double stopping_speed =
+      std::sqrt(2 * acceleration_ * std::fabs(error));
+  const double desired_speed =
+      direction * std::min(motion_speed_mm_per_s_, stopping_speed);
+  const double max_change = acceleration_ * dt;
+  speed_mm_per_s_ += std::max(-max_change,
+                              std::min(max_change,
+                                       desired_speed - speed_mm_per_s_));
+  double new_width = width_mm_ + speed_mm_per_s_ * dt;
+  if ((direction > 0 && new_width > motion_target_mm_) ||
+      (direction < 0 && new_width < motion_target_mm_)) {
+    new_width = motion_target_mm_;
+  }
+
+  force_ = 0;
+  if (part_present && new_width < params_.part_width_mm &&
+      speed_mm_per_s_ <= 0) {
+    force_ = stiffness * (params_.part_width_mm - new_width);
+    if (force_ >= force_limit_) {
+      // Blocked by the part.
+      width_mm_ = params_.part_width_mm - force_limit_ / stiffness;
+      force_ = force_limit_;
+      speed_mm_per_s_ = 0;
+      switch (motion_) {
+        case kMotionGrasp: {
+          grasping_state_ = kHolding;
+          FinishMotion(E_SUCCESS, now_ns);
+          break;
+        }
+        case kMotionPreposition: {
+          FinishMotion(E_AXIS_BLOCKED, now_ns);
+          if (!motion_stop_on_block_) { motion_ = kMotionClamp; }
+          break;
+        }
+        default: {
+          FinishMotion(E_AXIS_BLOCKED, now_ns);
+          break;
+        }
+      }
+      return;
+    }
+  }
+  width_mm_ = new_width;
+
+  if (std::fabs(motion_target_mm_ - width_mm_) < kPositionToleranceMm) {
+    speed_mm_per_s_ = 0;
+    switch (motion_) {
+      case kMotionHome: {
+        referenced_ = true;
+        FinishMotion(E_SUCCESS, now_ns);
+        break;
+      }
+      case kMotionGrasp: {
+        grasping_state_ = kNoPartFound;
+        grasps_no_part_found_++;
+        FinishMotion(E_CMD_FAILED, now_ns);
+        break;
+      }
+      case kMotionRelease: {
+        grasping_state_ = kIdle;
+        FinishMotion(E_SUCCESS, now_ns);
+        break;
+      }
+      default: {
+        FinishMotion(E_SUCCESS, now_ns);
+        break;
+      }
+    }
+  }
+}
+
+uint32_t WsgSimulator::SystemState() const {
+  uint32_t result = 0;
+  if (referenced_) { result |= SF_REFERENCED; }
+  if (speed_mm_per_s_ != 0) {
+    result |= SF_MOVING;
+  } else {
+    result |= SF_AXIS_STOPPED;
+  }
+  if (motion_ == kMotionNone &&
+      std::fabs(motion_target_mm_ - width_mm_) < kPositionToleranceMm) {
+    result |= SF_TARGET_POS_REACHED;
+  }
+  if (force_ > 0 && speed_mm_per_s_ == 0) { result |= SF_BLOCKED_MINUS; }
+  return result;
+}
+
+}  // namespace schunk_driver
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <utility>
+
+#include "wsg_command_message.h"
+#include "wsg_return_message.h"
+
+namespace schunk_driver {
+
+/// Parameters of a WsgSimulator.  Defaults approximate a WSG 50 with its
+/// standard fingers.
+struct WsgSimulatorParams {
+  double stroke_mm {110};
+  double max_speed_mm_per_s {420};
+  double max_acc_mm_per_ss {5000};
+  double min_force {5};
+  double nominal_force {80};
+  double overdrive_force {80};
+
+  /// Width of the part between the fingers, or zero for no part.
+  double part_width_mm {0};
+  /// Stiffness of the part (and fingers) once in contact.
+  double part_stiffness_n_per_mm {20};
+
+  /// Delay between receipt of a command and availability of its response.
+  int64_t response_latency_ns {500000};
+};
+
+/// A simple model of a WSG gripper and its command interface, for running
+/// the driver without hardware.  It implements the commands the driver uses
+/// (motion, configuration, status and automatic updates) with kinematics
+/// limited by the configured speed and acceleration, and a single compliant
+/// part that the fingers may close upon.
+///
+/// Time is supplied by the caller, so a simulator may be stepped by a
+/// SimulatedClock or by real time.
+class WsgSimulator {
+ public:
+  explicit WsgSimulator(const WsgSimulatorParams& params);
+
+  /// Accepts @p command as though it arrived from the network at @p now_ns.
+  void HandleCommand(const WsgCommandMessage& command, int64_t now_ns);
+
+  /// Advances the model to @p now_ns, queueing any responses and automatic
+  /// updates that fall due.
+  void Step(int64_t now_ns);
+
+  /// Removes and returns the oldest queued response available by
+  /// @p now_ns, or nullptr if there is none.
+  std::unique_ptr<WsgReturnMessage> TakeResponse(int64_t now_ns);
+
+  /// Places a part of @p width_mm between the fingers, or removes it (as if
+  /// dropped) if @p width_mm is zero.
+  void set_part_width_mm(double width_mm) { params_.part_width_mm = width_mm; }
+
+  double width_mm() const { return width_mm_; }
+  double speed_mm_per_s() const { return speed_mm_per_s_; }
+  double force() const { return force_; }
+  GraspingState grasping_state() const { return grasping_state_; }
+
+  /// Number of commands received, in total and of type @p command.
+  uint64_t commands_received() const { return commands_received_; }
+  uint64_t commands_received(int command) const;
+
+ private:
+  enum MotionType { kMotionNone, kMotionHome, kMotionPreposition,
+                    kMotionGrasp, kMotionRelease, kMotionClamp };
+
+  void Respond(int command, int status,
+               const std::vector<unsigned char>& params, int64_t now_ns);
+  template <typename T>
+  void RespondWith(int command, const T& value, int64_t now_ns);
+  void RespondWithStatus(int command, int64_t now_ns);
+  void StartMotion(int command, MotionType type, double target_mm,
+                   double speed_mm_per_s, int64_t now_ns);
+  void FinishMotion(int status, int64_t now_ns);
+  void Integrate(double dt, int64_t now_ns);
+  uint32_t SystemState() const;
+
+  WsgSimulatorParams params_;
+  int64_t last_step_ns_ {0};
+
+  double width_mm_;
+  double speed_mm_per_s_ {0};
+  double force_ {0};
+  double force_limit_;
+  double acceleration_;
+  bool referenced_ {false};
+  GraspingState grasping_state_ {kIdle};
+  // Grasp statistics, as reported by kGetGraspStats.
+  uint32_t grasps_ {0};
+  uint16_t grasps_no_part_found_ {0};
+  uint16_t grasps_part_lost_ {0};
+
+  MotionType motion_ {kMotionNone};
+  int motion_command_ {0};
+  double motion_target_mm_ {0};
+  double motion_speed_mm_per_s_ {0};
+  bool motion_stop_on_block_ {false};
+
+  // Automatic updates: command -> (period, next due time).
+  std::map<int, std::pair<int64_t, int64_t>> updates_;
+
+  // Pending responses with the time at which each becomes available.
+  std::deque<std::pair<int64_t, std::unique_ptr<WsgReturnMessage>>> responses_;
+
+  uint64_t commands_received_ {0};
+  std::map<int, uint64_t> commands_received_by_type_;
+};
+
+}  // namespace schunk_driver
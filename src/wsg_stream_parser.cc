@@ -0,0 +1,119 @@
+#include "wsg_stream_parser.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "crc.h"
+
+namespace schunk_driver {
+namespace {
+
+// Preamble, command and two length bytes; then the payload; then the CRC.
+const size_t kHeaderSize = 6;
+const size_t kCrcSize = 2;
+// Every return payload begins with a two-byte status code.
+const size_t kMinPayloadSize = 2;
+// No return message is longer (the longest, eg tactile finger data, are a
+// few hundred bytes), so a longer length field marks a false preamble; were
+// it believed, the parser would wait for up to 64 KiB of a frame that
+// never comes.
+const size_t kMaxPayloadSize = 1024;
+const unsigned char kPreambleByte = 0xaa;
+const size_t kPreambleSize = 3;
+
+}  // namespace
+
+WsgStreamParser::WsgStreamParser(size_t capacity)
+    : buffer_(capacity) {
+  assert(capacity >= kHeaderSize + kMinPayloadSize + kCrcSize);
+}
+
+unsigned char* WsgStreamParser::write_data() {
+  // Only the tail of a partial frame remains after Next(), so this copy is
+  // small.
+  if (begin_ > 0) {
+    memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+    end_ -= begin_;
+    begin_ = 0;
+  }
+  return buffer_.data() + end_;
+}
+
+void WsgStreamParser::Commit(size_t size) {
+  assert(size <= write_space());
+  end_ += size;
+  counters_.bytes += size;
+}
+
+size_t WsgStreamParser::Append(const unsigned char* data, size_t size) {
+  unsigned char* destination = write_data();
+  size = std::min(size, write_space());
+  memcpy(destination, data, size);
+  Commit(size);
+  return size;
+}
+
+bool WsgStreamParser::Next(WsgFrame* frame) {
+  const unsigned char* const data = buffer_.data();
+  while (end_ - begin_ >= kPreambleSize) {
+    // Find the next preamble, leaving at most a partial one buffered.
+    const unsigned char* start = data + begin_;
+    const unsigned char* const end = data + end_;
+    while ((start = static_cast<const unsigned char*>(
+                memchr(start, kPreambleByte, end - start)))) {
+      if (end - start < static_cast<ptrdiff_t>(kPreambleSize) ||
+          (start[1] == kPreambleByte && start[2] == kPreambleByte)) {
+        break;
+      }
+      ++start;
+    }
+    if (!start) {
+      Skip(end_ - begin_);
+      return false;
+    }
+    Skip(start - (data + begin_));
+    if (end_ - begin_ < kHeaderSize) { return false; }
+
+    const unsigned char* const header = data + begin_;
+    const size_t payload_size = header[4] + (header[5] << 8);
+    const size_t frame_size = kHeaderSize + payload_size + kCrcSize;
+    if (payload_size < kMinPayloadSize || payload_size > kMaxPayloadSize ||
+        frame_size > buffer_.size()) {
+      counters_.bad_lengths++;
+      Skip(1);
+      continue;
+    }
+    if (end_ - begin_ < frame_size) { return false; }
+
+    const uint16_t crc = header[frame_size - 2] + (header[frame_size - 1] << 8);
+    if (checksum_update_crc16(header, kHeaderSize + payload_size) != crc) {
+      counters_.checksum_errors++;
+      Skip(1);
+      continue;
+    }
+
+    frame->command = header[3];
+    frame->status = header[6] + (header[7] << 8);
+    frame->params = header + kHeaderSize + kMinPayloadSize;
+    frame->params_size = payload_size - kMinPayloadSize;
+    begin_ += frame_size;
+    skipping_ = false;
+    counters_.frames++;
+    if (begin_ == end_) { begin_ = end_ = 0; }
+    return true;
+  }
+  return false;
+}
+
+void WsgStreamParser::Skip(size_t size) {
+  if (size == 0) { return; }
+  if (!skipping_) {
+    counters_.resyncs++;
+    skipping_ = true;
+  }
+  counters_.bytes_skipped += size;
+  begin_ += size;
+}
+
+}  // namespace schunk_driver
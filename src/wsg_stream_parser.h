@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace schunk_driver {
+
+/// A return message frame located in a WsgStreamParser's buffer.  The params
+/// pointer is valid only until the parser's next write_data() call.
+struct WsgFrame {
+  int command {0};
+  int status {0};
+  const unsigned char* params {nullptr};
+  size_t params_size {0};
+};
+
+/// Extracts return message frames from a byte stream (such as the gripper's
+/// TCP interface) in which frames may be split across reads, several may
+/// arrive in one read, and corruption may occur.  Each frame is located by
+/// its 0xAA 0xAA 0xAA preamble and accepted only if its length is plausible
+/// (at most 1 KiB of payload) and its CRC matches; otherwise parsing resumes
+/// one byte on, at the next preamble.
+///
+/// Bytes are read directly into the parser's own buffer and frames are
+/// returned in place, so parsing neither copies nor allocates per frame:
+///
+///   size_t n = read(fd, parser.write_data(), parser.write_space());
+///   parser.Commit(n);
+///   WsgFrame frame;
+///   while (parser.Next(&frame)) { ... }
+class WsgStreamParser {
+ public:
+  struct Counters {
+    uint64_t bytes {0};            //< Bytes committed.
+    uint64_t frames {0};           //< Frames returned.
+    uint64_t checksum_errors {0};  //< Candidate frames failing the CRC.
+    uint64_t bad_lengths {0};      //< Candidate frames of impossible length.
+    uint64_t resyncs {0};          //< Runs of bytes skipped to find a frame.
+    uint64_t bytes_skipped {0};    //< Bytes discarded while resynchronizing.
+  };
+
+  /// Buffers up to @p capacity bytes, which also bounds the largest frame
+  /// accepted.
+  explicit WsgStreamParser(size_t capacity = 65536);
+
+  /// Returns where the next bytes should be written, first discarding any
+  /// consumed bytes (so invalidating frames previously returned).
+  unsigned char* write_data();
+
+  /// Space available at write_data(), once it has been called.
+  size_t write_space() const { return buffer_.size() - end_; }
+
+  /// Accepts @p size bytes written at write_data().
+  void Commit(size_t size);
+
+  /// Copies in and accepts @p size bytes; for callers that already hold
+  /// the bytes elsewhere.  Returns the number accepted, which is less than
+  /// @p size only if the buffer is full.
+  size_t Append(const unsigned char* data, size_t size);
+
+  /// Stores the next complete frame into @p frame and returns true, or
+  /// returns false if no complete frame is buffered.
+  bool Next(WsgFrame* frame);
+
+  /// Discards all buffered bytes.
+  void Reset() { begin_ = end_ = 0; }
+
+  const Counters& counters() const { return counters_; }
+
+ private:
+  // Discards @p size bytes at begin_ as garbage.
+  void Skip(size_t size);
+
+  std::vector<unsigned char> buffer_;
+  size_t begin_ {0};  //< First unconsumed byte.
+  size_t end_ {0};    //< One past the last committed byte.
+  bool skipping_ {false};
+  Counters counters_;
+};
+
+}  // namespace schunk_driver
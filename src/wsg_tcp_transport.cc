@@ -0,0 +1,115 @@
+#include "wsg_tcp_transport.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace schunk_driver {
+
+WsgTcpTransport::WsgTcpTransport(const char* gripper_addr,
+                                 in_port_t gripper_port)
+    : fd_(socket(AF_INET, SOCK_STREAM, 0)) {
+  assert(fd_ > 0);
+  int enable = 1;
+  if (setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY,
+                 &enable, sizeof(enable)) != 0) {
+    std::cerr << "TCP_NODELAY unavailable: " << errno << std::endl;
+  }
+  struct sockaddr_in gripper_sockaddr;
+  memset(&gripper_sockaddr, 0, sizeof(gripper_sockaddr));
+  gripper_sockaddr.sin_family = AF_INET;
+  gripper_sockaddr.sin_port = htons(gripper_port);
+  gripper_sockaddr.sin_addr.s_addr = inet_addr(gripper_addr);
+  int connect_result = connect(fd_, (struct sockaddr *) &gripper_sockaddr,
+                               sizeof(gripper_sockaddr));
+  if (connect_result != 0) {
+    std::cerr << "connect failed: " << errno
+              << " " << strerror(errno) << std::endl;
+    assert(connect_result == 0);
+    ::abort();
+  }
+  // Reads must not block; Send() waits for space itself.
+  fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+}
+
+WsgTcpTransport::~WsgTcpTransport() { close(fd_); }
+
+void WsgTcpTransport::Send(const WsgCommandMessage& msg) {
+  msg.Serialize(send_buffer_);
+  Write();
+}
+
+void WsgTcpTransport::SendFrames(
+    const std::vector<std::vector<unsigned char>>& frames) {
+  send_buffer_.clear();
+  for (const auto& frame : frames) {
+    send_buffer_.insert(send_buffer_.end(), frame.begin(), frame.end());
+  }
+  Write();
+}
+
+void WsgTcpTransport::Write() {
+  size_t sent = 0;
+  while (sent < send_buffer_.size()) {
+    ssize_t result = send(fd_, send_buffer_.data() + sent,
+                          send_buffer_.size() - sent, MSG_NOSIGNAL);
+    if (result >= 0) {
+      sent += result;
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      struct pollfd pfd = { fd_, POLLOUT, 0 };
+      poll(&pfd, 1, -1);
+    } else if (errno != EINTR) {
+      std::cerr << "Error writing to TCP socket " << errno
+                << " " << strerror(errno) << std::endl;
+      ::abort();
+    }
+  }
+}
+
+std::unique_ptr<WsgReturnMessage> WsgTcpTransport::Receive() {
+  WsgFrame frame;
+  while (!parser_.Next(&frame)) {
+    if (!Read()) {
+      return std::unique_ptr<WsgReturnMessage>(nullptr);
+    }
+  }
+  std::unique_ptr<WsgReturnMessage> result(new WsgReturnMessage(
+      frame.command, frame.status,
+      std::vector<unsigned char>(frame.params,
+                                 frame.params + frame.params_size)));
+  result->set_receive_time_ns(read_time_ns_);
+  return result;
+}
+
+bool WsgTcpTransport::Read() {
+  unsigned char* const data = parser_.write_data();
+  const ssize_t read_size = recv(fd_, data, parser_.write_space(),
+                                 MSG_DONTWAIT);
+  if (read_size > 0) {
+    parser_.Commit(read_size);
+    struct timespec time;
+    clock_gettime(CLOCK_REALTIME, &time);
+    read_time_ns_ = time.tv_sec * 1000000000L + time.tv_nsec;
+    return true;
+  } else if (read_size == 0) {
+    std::cerr << "Gripper closed the TCP connection" << std::endl;
+    ::abort();
+  } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+    std::cerr << "Error reading from TCP socket " << errno
+              << " " << strerror(errno) << std::endl;
+    ::abort();
+  }
+  return false;
+}
+
+}  // namespace schunk_driver
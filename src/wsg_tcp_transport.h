@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <netinet/in.h>
+
+#include "wsg_stream_parser.h"
+#include "wsg_transport.h"
+
+namespace schunk_driver {
+
+/// Exchanges messages with a gripper over its TCP command interface.  The
+/// connection uses TCP_NODELAY so that small commands are not held back to
+/// be coalesced, and return messages are recovered from the byte stream by a
+/// WsgStreamParser.
+///
+/// TCP does not support the kernel receive timestamps used for UDP, so
+/// messages are stamped with the time at which their bytes were read.
+///
+/// There is no reconnection: losing the connection, or any other socket
+/// error, aborts, for a supervisor to restart the driver.
+class WsgTcpTransport : public WsgTransport {
+ public:
+  /// Connects to @p gripper_addr:@p gripper_port, blocking until the
+  /// connection is established.
+  WsgTcpTransport(const char* gripper_addr, in_port_t gripper_port);
+
+  ~WsgTcpTransport();
+
+  void Send(const WsgCommandMessage& msg) override;
+
+  /// Sends @p frames with a single write where the socket has room.
+  void SendFrames(
+      const std::vector<std::vector<unsigned char>>& frames) override;
+
+  std::unique_ptr<WsgReturnMessage> Receive() override;
+
+  int receive_fd() const override { return fd_; }
+
+  const WsgStreamParser::Counters& counters() const {
+    return parser_.counters();
+  }
+
+ private:
+  // Reads whatever bytes are pending into parser_; returns false if none
+  // were.
+  bool Read();
+
+  // Writes all of send_buffer_, waiting for space as needed.
+  void Write();
+
+  const int fd_;
+  WsgStreamParser parser_;
+  int64_t read_time_ns_ {0};
+  std::vector<unsigned char> send_buffer_;
+};
+
+}  // namespace schunk_driver
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "wsg_command_message.h"
+#include "wsg_return_message.h"
+
+namespace schunk_driver {
+
+/// The means by which Wsg exchanges messages with a gripper.
+class WsgTransport {
+ public:
+  virtual ~WsgTransport() {}
+
+  virtual void Send(const WsgCommandMessage& msg) = 0;
+
+  /// Sends @p frames, each a message serialized by
+  /// WsgCommandMessage::Serialize(), back to back with as little delay
+  /// between them as the transport allows.  This default sends them one at a
+  /// time with Send().
+  virtual void SendFrames(
+      const std::vector<std::vector<unsigned char>>& frames) {
+    for (const auto& frame : frames) {
+      std::unique_ptr<WsgCommandMessage> msg =
+          WsgCommandMessage::Parse(frame.data(), frame.size());
+      assert(msg);
+      Send(*msg);
+    }
+  }
+
+  /// Returns the next pending message, stamped with its receive time, or
+  /// nullptr if none is pending.  Does not block.
+  virtual std::unique_ptr<WsgReturnMessage> Receive() = 0;
+
+  /// Total incoming messages the host dropped before Receive() could return
+  /// them, where the transport can tell.
+  virtual uint64_t receive_drops() const { return 0; }
+
+  /// A descriptor that becomes readable when Receive() may have a message
+  /// to return, or -1 if the transport has none and must be polled.
+  virtual int receive_fd() const { return -1; }
+};
+
+}  // namespace schunk_driver
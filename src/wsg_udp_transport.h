@@ -0,0 +1,43 @@
+#pragma once
+
+#include <netinet/in.h>
+
+#include "wsg_command_sender.h"
+#include "wsg_return_receiver.h"
+#include "wsg_transport.h"
+
+namespace schunk_driver {
+
+/// Exchanges messages with a gripper over its UDP command interface.
+class WsgUdpTransport : public WsgTransport {
+ public:
+  WsgUdpTransport(const char* local_addr, in_port_t local_port,
+                  const char* gripper_addr, in_port_t gripper_port)
+      : rx_(local_addr, local_port, gripper_addr, gripper_port),
+        tx_(local_addr, local_port, gripper_addr, gripper_port) {
+  }
+
+  void Send(const WsgCommandMessage& msg) override { tx_.Send(msg); }
+
+  void SendFrames(
+      const std::vector<std::vector<unsigned char>>& frames) override {
+    tx_.SendFrames(frames);
+  }
+
+  std::unique_ptr<WsgReturnMessage> Receive() override {
+    return rx_.Receive();
+  }
+
+  uint64_t receive_drops() const override { return rx_.drops(); }
+
+  int receive_fd() const override { return rx_.fd(); }
+
+  WsgReturnReceiver& rx() { return rx_; }
+  WsgCommandSender& tx() { return tx_; }
+
+ private:
+  WsgReturnReceiver rx_;
+  WsgCommandSender tx_;
+};
+
+}  // namespace schunk_driver